@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "axis-filter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+AxisFilter::AxisFilter(float rate) noexcept
+    : m_rate{(rate > 0) ? rate : 1.0f} {
+    // Unfiltered axes pass their inputs through.
+    m_alpha.fill(1.0f);
+    m_maxStep.fill(std::numeric_limits<float>::max());
+}
+
+bool AxisFilter::configure(uint32_t axis, const std::string &specification) noexcept {
+    bool retVal{false};
+    const std::size_t COLON{specification.find(':')};
+    if ( (axis < InputEvents::MAX_NUMBER_OF_AXES) && (std::string::npos != COLON) ) {
+        const std::string KIND{specification.substr(0, COLON)};
+        const float PARAMETER{std::strtof(specification.c_str() + COLON + 1, nullptr)};
+        if ( ("ema" == KIND) && (PARAMETER > 0) ) {
+            m_alpha[axis] = 1.0f - std::exp(-1000.0f / (PARAMETER * m_rate));
+            retVal = true;
+        }
+        else if ( ("slew" == KIND) && (PARAMETER > 0) ) {
+            m_maxStep[axis] = PARAMETER / 100.0f * 65535.0f / m_rate;
+            retVal = true;
+        }
+        else if ( ("median" == KIND) && (PARAMETER >= 1) && (PARAMETER <= MAX_MEDIAN_LENGTH) ) {
+            m_medianLength[axis] = static_cast<uint32_t>(PARAMETER);
+            m_medianAxes.push_back(axis);
+            retVal = true;
+        }
+    }
+    if (retVal) {
+        m_filteredAxes.set(axis);
+    }
+    return retVal;
+}
+
+const AxisFilter::Axes &AxisFilter::filteredAxes() const noexcept {
+    return m_filteredAxes;
+}
+
+void AxisFilter::input(uint32_t axis, int16_t value) noexcept {
+    m_input[axis] = value;
+    if (!m_hasInput.test(axis)) {
+        // Start from the first value instead of following it from 0.
+        m_output[axis] = m_target[axis] = value;
+        m_rounded[axis] = value;
+        for (auto &row : m_history) {
+            row[axis] = value;
+        }
+        m_hasInput.set(axis);
+    }
+    m_stepsUntilSettled = MAX_MEDIAN_LENGTH;
+}
+
+void AxisFilter::reset() noexcept {
+    m_hasInput.reset();
+}
+
+int16_t AxisFilter::output(uint32_t axis) const noexcept {
+    return m_rounded[axis];
+}
+
+AxisFilter::Axes AxisFilter::step() noexcept {
+    m_history[m_historySlot] = m_input;
+    m_historySlot = (m_historySlot + 1) % MAX_MEDIAN_LENGTH;
+
+    m_target = m_input;
+    for (uint32_t axis : m_medianAxes) {
+        std::array<float, MAX_MEDIAN_LENGTH> window;
+        const uint32_t LENGTH{m_medianLength[axis]};
+        for (uint32_t i{0}; i < LENGTH; i++) {
+            window[i] = m_history[(m_historySlot + MAX_MEDIAN_LENGTH - 1 - i) % MAX_MEDIAN_LENGTH][axis];
+        }
+        std::nth_element(window.begin(), window.begin() + LENGTH / 2, window.begin() + LENGTH);
+        m_target[axis] = window[LENGTH / 2];
+    }
+
+    for (std::size_t i{0}; i < InputEvents::MAX_NUMBER_OF_AXES; i++) {
+        const float DELTA{m_alpha[i] * (m_target[i] - m_output[i])};
+        m_output[i] += std::max(-m_maxStep[i], std::min(m_maxStep[i], DELTA));
+    }
+
+    Axes changed{};
+    for (std::size_t i{0}; i < InputEvents::MAX_NUMBER_OF_AXES; i++) {
+        const int16_t ROUNDED{static_cast<int16_t>(std::lround(m_output[i]))};
+        changed.set(i, ROUNDED != m_rounded[i]);
+        m_rounded[i] = ROUNDED;
+    }
+
+    m_stepsUntilSettled = (0 < m_stepsUntilSettled) ? m_stepsUntilSettled - 1 : 0;
+    return changed & m_filteredAxes;
+}
+
+bool AxisFilter::isSettled() const noexcept {
+    bool retVal{0 == m_stepsUntilSettled};
+    for (std::size_t i{0}; retVal && (i < InputEvents::MAX_NUMBER_OF_AXES); i++) {
+        retVal = !m_filteredAxes.test(i) || (std::fabs(m_target[i] - m_output[i]) < 0.5f);
+    }
+    return retVal;
+}
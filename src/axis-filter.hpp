@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AXIS_FILTER_HPP
+#define AXIS_FILTER_HPP
+
+#include "input-device.hpp"
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * This class filters raw axis values at a fixed rate. The filter state of
+ * all axes is kept as structure of arrays so that one step updates all axes
+ * in a single loop: Each output follows its target by the fraction alpha of
+ * the difference (exponential moving average), limited to maxStep (slew
+ * rate); an axis' target is its latest input or the median of its recent
+ * inputs.
+ */
+class AxisFilter {
+   private:
+    AxisFilter(const AxisFilter &) = delete;
+    AxisFilter(AxisFilter &&)      = delete;
+    AxisFilter &operator=(const AxisFilter &) = delete;
+    AxisFilter &operator=(AxisFilter &&) = delete;
+
+   public:
+    using Axes = std::bitset<InputEvents::MAX_NUMBER_OF_AXES>;
+
+    enum : uint32_t { MAX_MEDIAN_LENGTH = 15 };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param rate Frequency in Hz with which step is called.
+     */
+    explicit AxisFilter(float rate) noexcept;
+    ~AxisFilter() = default;
+
+    /**
+     * This method sets the filter for an axis.
+     *
+     * @param axis Axis to filter.
+     * @param specification ema:<time constant in ms>, slew:<percent of the axis' range per s>, or median:<number of samples>.
+     * @return true if the specification is valid.
+     */
+    bool configure(uint32_t axis, const std::string &specification) noexcept;
+
+    /**
+     * @return Axes with a filter.
+     */
+    const Axes &filteredAxes() const noexcept;
+
+    /**
+     * This method sets the latest raw value of an axis.
+     *
+     * @param axis Axis.
+     * @param value Raw value.
+     */
+    void input(uint32_t axis, int16_t value) noexcept;
+
+    /**
+     * This method lets the filters start over from the next inputs.
+     */
+    void reset() noexcept;
+
+    /**
+     * @param axis Axis.
+     * @return Filtered value.
+     */
+    int16_t output(uint32_t axis) const noexcept;
+
+    /**
+     * This method advances all filters by one period.
+     *
+     * @return Filtered axes whose output changed.
+     */
+    Axes step() noexcept;
+
+    /**
+     * @return true if all outputs reached their inputs so that step does not need to be called.
+     */
+    bool isSettled() const noexcept;
+
+   private:
+    const float m_rate;
+    Axes m_filteredAxes{};
+    Axes m_hasInput{};
+    std::vector<uint32_t> m_medianAxes{};
+    uint32_t m_stepsUntilSettled{0};
+
+    // Filter state and parameters per axis.
+    std::array<float, InputEvents::MAX_NUMBER_OF_AXES> m_input{};
+    std::array<float, InputEvents::MAX_NUMBER_OF_AXES> m_target{};
+    std::array<float, InputEvents::MAX_NUMBER_OF_AXES> m_output{};
+    std::array<float, InputEvents::MAX_NUMBER_OF_AXES> m_alpha{};
+    std::array<float, InputEvents::MAX_NUMBER_OF_AXES> m_maxStep{};
+    std::array<int16_t, InputEvents::MAX_NUMBER_OF_AXES> m_rounded{};
+    std::array<uint32_t, InputEvents::MAX_NUMBER_OF_AXES> m_medianLength{};
+
+    // Recent inputs of the median filters, one row of all axes per step.
+    std::array<std::array<float, InputEvents::MAX_NUMBER_OF_AXES>, MAX_MEDIAN_LENGTH> m_history{};
+    uint32_t m_historySlot{0};
+};
+
+#endif
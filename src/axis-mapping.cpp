@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "axis-mapping.hpp"
+
+#include <cmath>
+
+AxisMapping::AxisMapping(const std::function<float(float)> &map, const Curve &curve) noexcept
+    : m_table(65536, 0.0f) {
+    const bool HAS_CURVE{(curve.deadzone > 0.0f) || (curve.expo > 0.0f)};
+    for (int32_t value{-32768}; value <= 32767; value++) {
+        float percent{toPercent(static_cast<int16_t>(value))};
+        if (HAS_CURVE) {
+            // Shape the deflection [-1, 1] from the center of the axis.
+            const float DEFLECTION{(percent - 50.0f) / 50.0f};
+            const float MAGNITUDE{std::fabs(DEFLECTION)};
+            float shaped{(MAGNITUDE > curve.deadzone) ? (MAGNITUDE - curve.deadzone) / (1.0f - curve.deadzone) : 0.0f};
+            shaped = (1.0f - curve.expo) * shaped + curve.expo * shaped * shaped * shaped;
+            percent = 50.0f + 50.0f * std::copysign(shaped, DEFLECTION);
+        }
+
+        float v{map(percent)};
+        if (curve.step > 0.0f) {
+            v = ::roundf(v / curve.step) * curve.step;
+        }
+        // Clamp value to avoid showing "-0" (just "0" looks better imo)
+        if (v < 0.001f && v > -0.001f) {
+            v = 0;
+        }
+        m_table[static_cast<uint16_t>(value) ^ 0x8000u] = v;
+    }
+}
+
+float AxisMapping::toPercent(int16_t value) noexcept {
+    const int32_t MIN_AXES_VALUE = -32768;
+    const int32_t MAX_AXES_VALUE = 32767;
+    // this will return a percent value over the whole range
+    return static_cast<float>(value - MIN_AXES_VALUE)/static_cast<float>(MAX_AXES_VALUE-MIN_AXES_VALUE)*100.0f;
+}
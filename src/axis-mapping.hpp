@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AXIS_MAPPING_HPP
+#define AXIS_MAPPING_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * This class maps raw axis values [-32768, 32767] to output values through
+ * a table that is computed once, so that mapping an event is a single load.
+ *
+ * The table is built from a function mapping the percent of the axis' range
+ * [0, 100] to the output value; the percent is shaped by the response curve
+ * beforehand and the result is quantized to the given step afterwards.
+ */
+class AxisMapping {
+   private:
+    AxisMapping(const AxisMapping &) = delete;
+    AxisMapping(AxisMapping &&)      = delete;
+    AxisMapping &operator=(const AxisMapping &) = delete;
+    AxisMapping &operator=(AxisMapping &&) = delete;
+
+   public:
+    struct Curve {
+        // Fraction [0, 1) of the deflection around the center that is mapped to the center.
+        float deadzone{0};
+        // Fraction [0, 1] of cubic response mixed into the linear one.
+        float expo{0};
+        // Step to round the output values to; 0 disables rounding.
+        float step{0.25f};
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param map Function mapping the percent of the axis' range to an output value.
+     * @param curve Response curve to apply.
+     */
+    AxisMapping(const std::function<float(float)> &map, const Curve &curve) noexcept;
+    ~AxisMapping() = default;
+
+    /**
+     * @param value Raw axis value.
+     * @return Mapped value.
+     */
+    float map(int16_t value) const noexcept {
+        return m_table[static_cast<uint16_t>(value) ^ 0x8000u];
+    }
+
+    /**
+     * @param value Raw axis value.
+     * @return Percent [0, 100] of the axis' range without applying the curve.
+     */
+    static float toPercent(int16_t value) noexcept;
+
+   private:
+    std::vector<float> m_table;
+};
+
+#endif
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "batch-sender.hpp"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+BatchSender::BatchSender(const std::string &sendToAddress, uint16_t sendToPort, Protocol protocol, uint32_t redundancy) noexcept
+    : m_protocol{protocol}
+    , m_redundancy{(0 < redundancy) ? redundancy : 1}
+    , m_destination{sendToAddress + ":" + std::to_string(sendToPort)} {
+    struct addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = (Protocol::TCP == m_protocol) ? SOCK_STREAM : SOCK_DGRAM;
+    struct addrinfo *result{nullptr};
+    if (0 != ::getaddrinfo(sendToAddress.c_str(), nullptr, &hints, &result)) {
+        std::cerr << "[opendlv-device-ps3controller]: Invalid address: " << sendToAddress << std::endl;
+    }
+    else {
+        m_sendToAddress = *reinterpret_cast<struct sockaddr_in *>(result->ai_addr);
+        m_sendToAddress.sin_port = htons(sendToPort);
+        m_isResolved = true;
+        ::freeaddrinfo(result);
+    }
+
+    if (m_isResolved && (Protocol::UDP == m_protocol) && (-1 == (m_socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP)))) {
+        std::cerr << "[opendlv-device-ps3controller]: Could not create socket: " << errno << ": " << strerror(errno) << std::endl;
+    }
+    if (Protocol::TCP == m_protocol) {
+        std::lock_guard<std::mutex> lck(m_socketMutex);
+        connect();
+    }
+
+    for (std::size_t i{0}; i < MAX_NUMBER_OF_DATAGRAMS; i++) {
+        m_messages[i].msg_hdr.msg_name = &m_sendToAddress;
+        m_messages[i].msg_hdr.msg_namelen = sizeof(m_sendToAddress);
+        m_messages[i].msg_hdr.msg_iov = &m_datagrams[i];
+        m_messages[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+BatchSender::~BatchSender() {
+    flush();
+    if (-1 != m_socket) {
+        ::close(m_socket);
+    }
+}
+
+bool BatchSender::isOpen() const noexcept {
+    return m_isResolved && ((Protocol::TCP == m_protocol) || (-1 != m_socket));
+}
+
+void BatchSender::queue(const std::string &envelope) noexcept {
+    if (envelope.empty() || (MAX_DATAGRAM_SIZE < envelope.size())) {
+        return;
+    }
+    if ( (MAX_NUMBER_OF_DATAGRAMS == m_numberOfDatagrams) || (MAX_SIZE_OF_DATAGRAMS < m_bufferSize + envelope.size()) ) {
+        flush();
+    }
+    std::memcpy(m_buffer.data() + m_bufferSize, envelope.data(), envelope.size());
+    m_datagrams[m_numberOfDatagrams].iov_base = m_buffer.data() + m_bufferSize;
+    m_datagrams[m_numberOfDatagrams].iov_len = envelope.size();
+    m_bufferSize += envelope.size();
+    m_numberOfDatagrams++;
+}
+
+void BatchSender::flush() noexcept {
+    if (0 < m_numberOfDatagrams) {
+        std::lock_guard<std::mutex> lck(m_socketMutex);
+        if (Protocol::TCP == m_protocol) {
+            // The queued envelopes are stored back to back.
+            write(m_buffer.data(), m_bufferSize);
+        }
+        else {
+            for (uint32_t copy{0}; copy < m_redundancy; copy++) {
+                std::size_t sent{0};
+                while ( (-1 != m_socket) && (sent < m_numberOfDatagrams) ) {
+                    const int RETVAL{::sendmmsg(m_socket, &m_messages[sent], static_cast<unsigned int>(m_numberOfDatagrams - sent), 0)};
+                    if (0 < RETVAL) {
+                        sent += static_cast<std::size_t>(RETVAL);
+                    }
+                    else if ( (0 == RETVAL) || (EINTR != errno) ) {
+                        // Like UDPSender::send, a datagram that cannot be sent is dropped.
+                        sent++;
+                    }
+                }
+            }
+        }
+    }
+    m_numberOfDatagrams = 0;
+    m_bufferSize = 0;
+}
+
+void BatchSender::send(const std::string &envelope) noexcept {
+    if (envelope.empty() || (MAX_DATAGRAM_SIZE < envelope.size())) {
+        return;
+    }
+    std::lock_guard<std::mutex> lck(m_socketMutex);
+    if (Protocol::TCP == m_protocol) {
+        write(envelope.data(), envelope.size());
+    }
+    else {
+        for (uint32_t copy{0}; (-1 != m_socket) && (copy < m_redundancy); copy++) {
+            ::sendto(m_socket, envelope.data(), envelope.size(), 0, reinterpret_cast<const struct sockaddr *>(&m_sendToAddress), sizeof(m_sendToAddress));
+        }
+    }
+}
+
+bool BatchSender::connect() noexcept {
+    if (!m_isResolved) {
+        return false;
+    }
+    if ( (-1 != m_socket) && !m_isConnecting ) {
+        return true;
+    }
+
+    int error{0};
+    if (-1 == m_socket) {
+        const std::chrono::steady_clock::time_point NOW{std::chrono::steady_clock::now()};
+        if (NOW - m_lastConnectAttempt < std::chrono::seconds(1)) {
+            return false;
+        }
+        m_lastConnectAttempt = NOW;
+
+        if (-1 == (m_socket = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP))) {
+            error = errno;
+        }
+        else {
+            // Small envelopes must not wait for further data.
+            int noDelay{1};
+            ::setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            if (0 > ::connect(m_socket, reinterpret_cast<const struct sockaddr *>(&m_sendToAddress), sizeof(m_sendToAddress))) {
+                error = errno;
+            }
+            // The handshake is completed by the following calls.
+            m_isConnecting = (EINPROGRESS == error);
+            error = m_isConnecting ? 0 : error;
+        }
+    }
+    else {
+        // Check without waiting whether the handshake completed.
+        struct pollfd pfd{m_socket, POLLOUT, 0};
+        if (0 < ::poll(&pfd, 1, 0)) {
+            socklen_t length{sizeof(error)};
+            if (0 > ::getsockopt(m_socket, SOL_SOCKET, SO_ERROR, &error, &length)) {
+                error = errno;
+            }
+            m_isConnecting = false;
+        }
+    }
+
+    if (0 != error) {
+        if (!m_hasReportedConnectFailure) {
+            std::cerr << "[opendlv-device-ps3controller]: Could not connect to " << m_destination << ", retrying: " << error << ": " << strerror(error) << std::endl;
+            m_hasReportedConnectFailure = true;
+        }
+        if (-1 != m_socket) {
+            ::close(m_socket);
+            m_socket = -1;
+        }
+        m_isConnecting = false;
+    }
+    else if ( (-1 != m_socket) && !m_isConnecting ) {
+        std::clog << "[opendlv-device-ps3controller]: Connected to " << m_destination << "." << std::endl;
+        m_hasReportedConnectFailure = false;
+    }
+    return (-1 != m_socket) && !m_isConnecting;
+}
+
+void BatchSender::disconnect() noexcept {
+    std::cerr << "[opendlv-device-ps3controller]: Lost connection to " << m_destination << ": " << errno << ": " << strerror(errno) << std::endl;
+    ::close(m_socket);
+    m_socket = -1;
+    m_isConnecting = false;
+    m_pendingSize = 0;
+}
+
+bool BatchSender::writePending() noexcept {
+    std::size_t written{0};
+    while ( (-1 != m_socket) && (written < m_pendingSize) ) {
+        const ssize_t RETVAL{::send(m_socket, m_pending.data() + written, m_pendingSize - written, MSG_NOSIGNAL | MSG_DONTWAIT)};
+        if (0 < RETVAL) {
+            written += static_cast<std::size_t>(RETVAL);
+        }
+        else if ( (0 > RETVAL) && (EINTR == errno) ) {
+            continue;
+        }
+        else if ( (0 > RETVAL) && ((EAGAIN == errno) || (EWOULDBLOCK == errno)) ) {
+            break;
+        }
+        else {
+            disconnect();
+        }
+    }
+    if (-1 == m_socket) {
+        return false;
+    }
+
+    std::memmove(m_pending.data(), m_pending.data() + written, m_pendingSize - written);
+    m_pendingSize -= written;
+    if ( (0 < m_pendingSize) && (std::chrono::steady_clock::now() - m_pendingSince > std::chrono::seconds(1)) ) {
+        errno = ETIMEDOUT;
+        disconnect();
+    }
+    return 0 == m_pendingSize;
+}
+
+void BatchSender::write(const char *data, std::size_t length) noexcept {
+    if ( !connect() || !writePending() ) {
+        // Newer values follow with the next call.
+        return;
+    }
+
+    std::size_t written{0};
+    while ( (-1 != m_socket) && (written < length) ) {
+        const ssize_t RETVAL{::send(m_socket, data + written, length - written, MSG_NOSIGNAL | MSG_DONTWAIT)};
+        if (0 < RETVAL) {
+            written += static_cast<std::size_t>(RETVAL);
+        }
+        else if ( (0 > RETVAL) && (EINTR == errno) ) {
+            continue;
+        }
+        else if ( (0 > RETVAL) && ((EAGAIN == errno) || (EWOULDBLOCK == errno)) ) {
+            if (0 < written) {
+                // Keep the rest of the started envelopes to keep the stream in sync.
+                std::memcpy(m_pending.data(), data + written, length - written);
+                m_pendingSize = length - written;
+                m_pendingSince = std::chrono::steady_clock::now();
+            }
+            break;
+        }
+        else {
+            disconnect();
+        }
+    }
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BATCH_SENDER_HPP
+#define BATCH_SENDER_HPP
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/**
+ * This class sends serialized envelopes like cluon::UDPSender, but collects
+ * them first and hands all of them to the kernel with one sendmmsg call.
+ * Each envelope is still sent as a datagram of its own because receivers
+ * like cluon::OD4Session only extract the first envelope of a datagram.
+ *
+ * With UDP, the envelopes are sent to a multicast group or a unicast
+ * address; with a redundancy larger than 1, all envelopes of a batch are
+ * sent that often in turn so that the loss of single datagrams is tolerated.
+ * With TCP, the envelopes of a batch are written at once to a persistent
+ * connection with TCP_NODELAY; the receiver splits the stream at the OD4
+ * headers. No call blocks on the network: The connection is established
+ * asynchronously over the following calls, envelopes are dropped while it
+ * is not established or while the socket's send buffer is full, and the
+ * rest of a partially written envelope is kept and written first by the
+ * following calls. A connection that does not take such a rest within one
+ * second is closed, and a lost connection is reestablished at most once
+ * per second.
+ *
+ * The queued envelopes are copied into preallocated buffers; queue and flush
+ * are meant to be used from one thread only, send from any thread.
+ */
+class BatchSender {
+   private:
+    BatchSender(const BatchSender &) = delete;
+    BatchSender(BatchSender &&)      = delete;
+    BatchSender &operator=(const BatchSender &) = delete;
+    BatchSender &operator=(BatchSender &&) = delete;
+
+   public:
+    enum class Protocol { UDP, TCP };
+
+    /**
+     * Constructor.
+     *
+     * @param sendToAddress IPv4 address or name of the host to send to.
+     * @param sendToPort Port to send to.
+     * @param protocol Protocol to send with.
+     * @param redundancy Number of times to send each envelope with UDP.
+     */
+    BatchSender(const std::string &sendToAddress, uint16_t sendToPort, Protocol protocol = Protocol::UDP, uint32_t redundancy = 1) noexcept;
+    ~BatchSender();
+
+    /**
+     * @return true if the address could be resolved and a UDP socket created.
+     */
+    bool isOpen() const noexcept;
+
+    /**
+     * This method queues an envelope; the queued envelopes are sent when
+     * the buffers are full or flush is called.
+     *
+     * @param envelope Serialized envelope to send.
+     */
+    void queue(const std::string &envelope) noexcept;
+
+    /**
+     * This method sends all queued envelopes.
+     */
+    void flush() noexcept;
+
+    /**
+     * This method sends an envelope right away without waiting for flush.
+     *
+     * @param envelope Serialized envelope to send.
+     */
+    void send(const std::string &envelope) noexcept;
+
+   private:
+    /**
+     * @return true if the connection is established; starts or continues connecting otherwise.
+     */
+    bool connect() noexcept;
+    void disconnect() noexcept;
+    void write(const char *data, std::size_t length) noexcept;
+
+    /**
+     * @return true if the rest of a partially written envelope could be written.
+     */
+    bool writePending() noexcept;
+
+   private:
+    enum : std::size_t {
+        MAX_NUMBER_OF_DATAGRAMS = 64,
+        MAX_SIZE_OF_DATAGRAMS   = 64 * 1024,
+        // Largest UDP payload over IPv4.
+        MAX_DATAGRAM_SIZE       = 65507,
+    };
+
+    Protocol m_protocol;
+    uint32_t m_redundancy;
+    std::string m_destination;
+    bool m_isResolved{false};
+
+    // Serializes sending from flush and send.
+    std::mutex m_socketMutex{};
+    int m_socket{-1};
+    struct sockaddr_in m_sendToAddress{};
+    std::chrono::steady_clock::time_point m_lastConnectAttempt{};
+    bool m_isConnecting{false};
+    bool m_hasReportedConnectFailure{false};
+
+    // Rest of a partially written envelope with TCP.
+    std::array<char, MAX_SIZE_OF_DATAGRAMS> m_pending{};
+    std::size_t m_pendingSize{0};
+    std::chrono::steady_clock::time_point m_pendingSince{};
+
+    std::array<char, MAX_SIZE_OF_DATAGRAMS> m_buffer{};
+    std::size_t m_bufferSize{0};
+    std::array<struct iovec, MAX_NUMBER_OF_DATAGRAMS> m_datagrams{};
+    std::array<struct mmsghdr, MAX_NUMBER_OF_DATAGRAMS> m_messages{};
+    std::size_t m_numberOfDatagrams{0};
+};
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "controller-profile.hpp"
+#include "input-device.hpp"
+
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    // Layouts reported by the Linux joystick API.
+    const std::array<ControllerProfile, 6> BUILT_IN_PROFILES{{
+        // hid-sony: left stick X, right stick Y.
+        {"ps3", 0, 4},
+        // hid-playstation (Linux 5.12 and later) and hid-sony (DualShock 4): left stick X/Y,
+        // L2, right stick X/Y, R2, i.e. ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY, ABS_RZ.
+        {"ps4", 0, 4},
+        // hid-generic (DualShock 4 without the Sony drivers): left stick X/Y, right stick X,
+        // L2, R2, right stick Y; this is the layout --ps4 was written for originally.
+        {"ps4-generic", 0, 5},
+        // xpad: left stick X, right stick Y.
+        {"xbox", 0, 4},
+        // Logitech gamepads in DirectInput mode: right stick Y follows right stick X.
+        {"logitech", 0, 3},
+        // Single stick: left stick X and Y.
+        {"generic", 0, 1},
+    }};
+
+    std::string trim(const std::string &s) noexcept {
+        const std::size_t BEGIN{s.find_first_not_of(" \t\r")};
+        const std::size_t END{s.find_last_not_of(" \t\r")};
+        return (std::string::npos == BEGIN) ? "" : s.substr(BEGIN, END - BEGIN + 1);
+    }
+}
+
+std::pair<bool, ControllerProfile> loadControllerProfile(const std::string &profile) noexcept {
+    for (const ControllerProfile &p : BUILT_IN_PROFILES) {
+        if (p.name == profile) {
+            return std::make_pair(true, p);
+        }
+    }
+
+    bool isValid{true};
+    ControllerProfile p;
+    p.name = profile;
+    std::ifstream file(profile);
+    if (!file.good()) {
+        std::cerr << "[opendlv-device-ps3controller]: Unknown controller profile: " << profile << " (expected ps3, ps4, ps4-generic, xbox, logitech, generic, or a file)." << std::endl;
+        isValid = false;
+    }
+    std::string line;
+    while (isValid && std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || ('#' == line[0])) {
+            continue;
+        }
+        const std::size_t EQUALS{line.find('=')};
+        const std::string KEY{trim(line.substr(0, EQUALS))};
+        const std::string VALUE{(std::string::npos == EQUALS) ? "" : trim(line.substr(EQUALS + 1))};
+        if ("name" == KEY) {
+            p.name = VALUE;
+        }
+        else if ( ("steering_axis" == KEY) || ("acceleration_axis" == KEY) ) {
+            std::stringstream sstr{VALUE};
+            uint32_t axis{0};
+            isValid = static_cast<bool>(sstr >> axis) && sstr.eof() && (axis < InputEvents::MAX_NUMBER_OF_AXES);
+            (("steering_axis" == KEY) ? p.steeringAxis : p.accelerationAxis) = static_cast<uint8_t>(axis);
+        }
+        else {
+            isValid = false;
+        }
+        if (!isValid) {
+            std::cerr << "[opendlv-device-ps3controller]: Invalid line in " << profile << ": " << line << std::endl;
+        }
+    }
+    return std::make_pair(isValid, p);
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONTROLLER_PROFILE_HPP
+#define CONTROLLER_PROFILE_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+/**
+ * Layout of a controller: the axes (numbered like the joystick API does)
+ * that are mapped to steering and acceleration.
+ */
+struct ControllerProfile {
+    std::string name{"ps3"};
+    uint8_t steeringAxis{0};
+    uint8_t accelerationAxis{4};
+};
+
+/**
+ * This method resolves a controller profile: either one of the built-in
+ * ones (ps3, ps4, ps4-generic, xbox, logitech, generic), or a file with
+ * lines of the form "key = value" setting steering_axis, acceleration_axis,
+ * and name; lines starting with # are ignored.
+ *
+ * @param profile Name of a built-in profile or path to a profile file.
+ * @return Pair of true and the profile, or false if it is unknown or invalid.
+ */
+std::pair<bool, ControllerProfile> loadControllerProfile(const std::string &profile) noexcept;
+
+#endif
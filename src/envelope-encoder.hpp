@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENVELOPE_ENCODER_HPP
+#define ENVELOPE_ENCODER_HPP
+
+#include "cluon-complete.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * This class serializes messages of type T into OD4 envelopes (including the
+ * OD4 header) byte-compatible with cluon::serializeEnvelope. All buffers are
+ * allocated once: The payload is encoded field by field through the accept
+ * method generated from the message specification, and the result is handed
+ * out as a string whose capacity is reused for every message.
+ *
+ * Messages with nested messages or payloads larger than MAX_PAYLOAD_SIZE are
+ * not supported; encode returns an empty string for them.
+ */
+template <typename T, std::size_t MAX_PAYLOAD_SIZE = 256, uint32_t MAX_FIELD_IDENTIFIER = 32>
+class EnvelopeEncoder {
+   private:
+    EnvelopeEncoder(const EnvelopeEncoder &) = delete;
+    EnvelopeEncoder(EnvelopeEncoder &&)      = delete;
+    EnvelopeEncoder &operator=(const EnvelopeEncoder &) = delete;
+    EnvelopeEncoder &operator=(EnvelopeEncoder &&) = delete;
+
+   public:
+    EnvelopeEncoder() noexcept {
+        m_serializedEnvelope.reserve(MAX_ENVELOPE_SIZE);
+    }
+    ~EnvelopeEncoder() = default;
+
+    /**
+     * This method serializes the given message.
+     *
+     * @param message Message to serialize.
+     * @param sampleTimeStamp Time point when the message's content was captured (default = sent time point).
+     * @param senderStamp Sender stamp.
+     * @return Serialized envelope that stays valid until the next call or an empty string on failure.
+     */
+    std::string &encode(T &message, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t senderStamp) noexcept {
+        m_payload.size = 0;
+        m_payload.hasOverflow = false;
+        for (uint32_t fieldIdentifier{1}; fieldIdentifier <= MAX_FIELD_IDENTIFIER; fieldIdentifier++) {
+            message.accept(fieldIdentifier, *this);
+        }
+
+        cluon::data::TimeStamp sent{cluon::time::now()};
+        const bool HAS_SAMPLE_TIME_STAMP{0 != (sampleTimeStamp.seconds() + sampleTimeStamp.microseconds())};
+
+        m_envelope.size = 0;
+        m_envelope.hasOverflow = m_payload.hasOverflow;
+        // OD4 header; bytes 2-4 hold the little endian length and are set below.
+        m_envelope.put(0x0D);
+        m_envelope.put(static_cast<char>(0xA4));
+        m_envelope.put(0);
+        m_envelope.put(0);
+        m_envelope.put(0);
+        toKeyValue(m_envelope, 1, toZigZag(static_cast<int64_t>(T::ID())));
+        m_envelope.toVarInt(encodeKey(2, cluon::ProtoConstants::LENGTH_DELIMITED));
+        m_envelope.toVarInt(m_payload.size);
+        m_envelope.write(m_payload.data.data(), m_payload.size);
+        toTimeStamp(m_envelope, 3, sent);
+        toTimeStamp(m_envelope, 4, cluon::data::TimeStamp());
+        toTimeStamp(m_envelope, 5, (HAS_SAMPLE_TIME_STAMP ? sampleTimeStamp : sent));
+        toKeyValue(m_envelope, 6, senderStamp);
+
+        m_serializedEnvelope.clear();
+        if (!m_envelope.hasOverflow) {
+            const std::size_t LENGTH{m_envelope.size - OD4_HEADER_SIZE};
+            m_envelope.data[2] = static_cast<char>(LENGTH & 0xFF);
+            m_envelope.data[3] = static_cast<char>((LENGTH >> 8) & 0xFF);
+            m_envelope.data[4] = static_cast<char>((LENGTH >> 16) & 0xFF);
+            m_serializedEnvelope.assign(m_envelope.data.data(), m_envelope.size);
+        }
+        return m_serializedEnvelope;
+    }
+
+   public:
+    // The following methods are called from the message's accept method.
+
+    void visit(uint32_t id, std::string &&, std::string &&, bool &v) noexcept {
+        toKeyValue(m_payload, id, (v ? 1u : 0u));
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, char &v) noexcept {
+        toKeyValue(m_payload, id, static_cast<uint8_t>(v));
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, int8_t &v) noexcept {
+        toKeyValue(m_payload, id, static_cast<uint8_t>(toZigZag(v)));
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, uint8_t &v) noexcept {
+        toKeyValue(m_payload, id, v);
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, int16_t &v) noexcept {
+        toKeyValue(m_payload, id, static_cast<uint16_t>(toZigZag(v)));
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, uint16_t &v) noexcept {
+        toKeyValue(m_payload, id, v);
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, int32_t &v) noexcept {
+        toKeyValue(m_payload, id, static_cast<uint32_t>(toZigZag(v)));
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, uint32_t &v) noexcept {
+        toKeyValue(m_payload, id, v);
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, int64_t &v) noexcept {
+        toKeyValue(m_payload, id, toZigZag(v));
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, uint64_t &v) noexcept {
+        toKeyValue(m_payload, id, v);
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, float &v) noexcept {
+        uint32_t _v{0};
+        std::memcpy(&_v, &v, sizeof(float));
+        _v = htole32(_v);
+        m_payload.toVarInt(encodeKey(id, cluon::ProtoConstants::FOUR_BYTES));
+        m_payload.write(reinterpret_cast<const char *>(&_v), sizeof(uint32_t));
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, double &v) noexcept {
+        uint64_t _v{0};
+        std::memcpy(&_v, &v, sizeof(double));
+        _v = htole64(_v);
+        m_payload.toVarInt(encodeKey(id, cluon::ProtoConstants::EIGHT_BYTES));
+        m_payload.write(reinterpret_cast<const char *>(&_v), sizeof(uint64_t));
+    }
+    void visit(uint32_t id, std::string &&, std::string &&, std::string &v) noexcept {
+        m_payload.toVarInt(encodeKey(id, cluon::ProtoConstants::LENGTH_DELIMITED));
+        m_payload.toVarInt(v.size());
+        m_payload.write(v.data(), v.size());
+    }
+    template <typename U>
+    void visit(uint32_t, std::string &&, std::string &&, U &) noexcept {
+        // Nested messages are not supported.
+        m_payload.hasOverflow = true;
+    }
+
+   private:
+    enum : std::size_t {
+        OD4_HEADER_SIZE   = 5,
+        MAX_ENVELOPE_SIZE = MAX_PAYLOAD_SIZE + 128,
+    };
+
+    template <std::size_t CAPACITY>
+    struct Buffer {
+        std::array<char, CAPACITY> data{};
+        std::size_t size{0};
+        bool hasOverflow{false};
+
+        void put(char c) noexcept {
+            write(&c, 1);
+        }
+        void write(const char *bytes, std::size_t length) noexcept {
+            if (size + length > CAPACITY) {
+                hasOverflow = true;
+            }
+            else {
+                std::memcpy(data.data() + size, bytes, length);
+                size += length;
+            }
+        }
+        void toVarInt(uint64_t v) noexcept {
+            while (0x7f < v) {
+                // Use the MSB to indicate value overflow for more bytes to come.
+                put(static_cast<char>((static_cast<uint8_t>(v & 0x7f)) | 0x80));
+                v >>= 7;
+            }
+            put(static_cast<char>(v));
+        }
+    };
+
+    static uint64_t encodeKey(uint32_t fieldIdentifier, cluon::ProtoConstants protoType) noexcept {
+        return (static_cast<uint64_t>(fieldIdentifier) << 0x3) | static_cast<uint8_t>(protoType);
+    }
+
+    static uint64_t toZigZag(int64_t v) noexcept {
+        return static_cast<uint64_t>((v << 1) ^ (v >> 63));
+    }
+
+    template <typename BUFFER>
+    static void toKeyValue(BUFFER &buffer, uint32_t fieldIdentifier, uint64_t v) noexcept {
+        buffer.toVarInt(encodeKey(fieldIdentifier, cluon::ProtoConstants::VARINT));
+        buffer.toVarInt(v);
+    }
+
+    template <typename BUFFER>
+    static void toTimeStamp(BUFFER &buffer, uint32_t fieldIdentifier, const cluon::data::TimeStamp &timeStamp) noexcept {
+        Buffer<32> nested;
+        toKeyValue(nested, 1, static_cast<uint32_t>(toZigZag(timeStamp.seconds())));
+        toKeyValue(nested, 2, static_cast<uint32_t>(toZigZag(timeStamp.microseconds())));
+        buffer.toVarInt(encodeKey(fieldIdentifier, cluon::ProtoConstants::LENGTH_DELIMITED));
+        buffer.toVarInt(nested.size);
+        buffer.write(nested.data.data(), nested.size);
+    }
+
+   private:
+    Buffer<MAX_PAYLOAD_SIZE> m_payload{};
+    Buffer<MAX_ENVELOPE_SIZE> m_envelope{};
+    std::string m_serializedEnvelope{};
+};
+
+#endif
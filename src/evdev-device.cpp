@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "evdev-device.hpp"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+// Older kernel headers only provide the timeval member.
+#ifndef input_event_sec
+    #define input_event_sec time.tv_sec
+    #define input_event_usec time.tv_usec
+#endif
+
+namespace {
+    bool isBitSet(const uint8_t *bits, uint32_t bit) noexcept {
+        return 0 != (bits[bit / 8] & (1u << (bit % 8)));
+    }
+
+    int64_t timespecToMicroseconds(const struct timespec &ts) noexcept {
+        return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 + static_cast<int64_t>(ts.tv_nsec) / 1000;
+    }
+}
+
+EvdevDevice::EvdevDevice(int fd) noexcept
+    : m_fd{fd} {
+    char name_of_ps3controller[80];
+    if (::ioctl(m_fd, EVIOCGNAME(sizeof(name_of_ps3controller)), name_of_ps3controller) < 0) {
+        ::strncpy(name_of_ps3controller, "Unknown", sizeof(name_of_ps3controller));
+    }
+    name_of_ps3controller[sizeof(name_of_ps3controller) - 1] = '\0';
+    m_name = std::string(name_of_ps3controller);
+
+    // Prefer timestamps that are not affected by changes of the wall clock.
+    int clockId{CLOCK_MONOTONIC};
+    m_isMonotonicClock = (0 == ::ioctl(m_fd, EVIOCSCLOCKID, &clockId));
+
+    // Number the axes in ascending order of their ABS codes like the joystick API.
+    uint8_t absBits[ABS_CNT / 8 + 1]{};
+    ::ioctl(m_fd, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits);
+    m_axisNumber.fill(-1);
+    for (uint32_t code{0}; code < ABS_CNT; code++) {
+        if (isBitSet(absBits, code) && (0 == ::ioctl(m_fd, EVIOCGABS(code), &m_axisRange[code])) && (m_axisRange[code].maximum > m_axisRange[code].minimum)) {
+            m_axisNumber[code] = static_cast<int16_t>(m_numberOfAxes++);
+        }
+    }
+
+    // The joystick API numbers the buttons from BTN_JOYSTICK on first and those from BTN_MISC on last.
+    uint8_t keyBits[KEY_CNT / 8 + 1]{};
+    ::ioctl(m_fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits);
+    m_buttonNumber.fill(-1);
+    for (uint32_t code{BTN_JOYSTICK}; code < KEY_CNT + (BTN_JOYSTICK - BTN_MISC); code++) {
+        const uint32_t CODE{(code < KEY_CNT) ? code : code - KEY_CNT + BTN_MISC};
+        if (isBitSet(keyBits, CODE)) {
+            m_buttonNumber[CODE] = static_cast<int16_t>(m_numberOfButtons++);
+        }
+    }
+
+    // Use non blocking reading.
+    ::fcntl(m_fd, F_SETFL, O_NONBLOCK);
+}
+
+EvdevDevice::~EvdevDevice() {
+    ::close(m_fd);
+}
+
+std::string EvdevDevice::name() const noexcept {
+    return m_name;
+}
+
+uint32_t EvdevDevice::numberOfAxes() const noexcept {
+    return m_numberOfAxes;
+}
+
+uint32_t EvdevDevice::numberOfButtons() const noexcept {
+    return m_numberOfButtons;
+}
+
+int EvdevDevice::fileDescriptor() const noexcept {
+    return m_fd;
+}
+
+bool EvdevDevice::read(InputEvents &events) noexcept {
+    if (m_needsSynchronization) {
+        // Hand out the initial values similar to the joystick API's JS_EVENT_INIT events.
+        struct timespec realtime{};
+        ::clock_gettime(CLOCK_REALTIME, &realtime);
+        synchronize();
+        commit(events, timespecToMicroseconds(realtime));
+        m_needsSynchronization = false;
+    }
+
+    ssize_t bytesRead{0};
+    do {
+        bytesRead = ::read(m_fd, m_events, sizeof(m_events));
+        const std::size_t NUMBER_OF_EVENTS{(0 < bytesRead) ? static_cast<std::size_t>(bytesRead) / sizeof(struct input_event) : 0};
+        events.numberOfEvents += static_cast<uint32_t>(NUMBER_OF_EVENTS);
+        for (std::size_t i{0}; i < NUMBER_OF_EVENTS; i++) {
+            const struct input_event &ev = m_events[i];
+            if (EV_SYN == ev.type) {
+                if (SYN_REPORT == ev.code) {
+                    if (m_isDropping) {
+                        // The frame following SYN_DROPPED is incomplete; read the current state instead.
+                        synchronize();
+                        m_isDropping = false;
+                    }
+                    commit(events, toMicroseconds(ev));
+                }
+                else if (SYN_DROPPED == ev.code) {
+                    m_isDropping = true;
+                }
+            }
+            else if ( !m_isDropping && (EV_ABS == ev.type) && (ev.code < ABS_CNT) && (-1 < m_axisNumber[ev.code]) ) {
+                const std::size_t AXIS{static_cast<std::size_t>(m_axisNumber[ev.code])};
+                m_frame.axisValues[AXIS] = scale(ev.code, ev.value);
+                m_frame.updatedAxes.set(AXIS);
+            }
+            else if ( !m_isDropping && (EV_KEY == ev.type) && (ev.code < KEY_CNT) && (-1 < m_buttonNumber[ev.code]) ) {
+                // Key repeats (value 2) keep the button pressed.
+                const std::size_t BUTTON{static_cast<std::size_t>(m_buttonNumber[ev.code])};
+                m_frame.buttons.set(BUTTON, 0 != ev.value);
+                m_frame.updatedButtons.set(BUTTON);
+            }
+        }
+    } while (static_cast<ssize_t>(sizeof(m_events)) == bytesRead);
+
+    bool retVal{true};
+    if ( (0 > bytesRead) && (errno != EAGAIN) ) {
+        std::cerr << "[opendlv-device-ps3controller]: Error: " << errno << ": " << strerror(errno) << std::endl;
+        retVal = false;
+    }
+    return retVal;
+}
+
+void EvdevDevice::commit(InputEvents &events, int64_t sampleTimeInMicroseconds) noexcept {
+    for (uint32_t axis{0}; axis < m_numberOfAxes; axis++) {
+        if (m_frame.updatedAxes.test(axis)) {
+            events.axisValues[axis] = m_frame.axisValues[axis];
+            events.axisSampleTimesInMicroseconds[axis] = sampleTimeInMicroseconds;
+        }
+    }
+    events.updatedAxes |= m_frame.updatedAxes;
+    m_frame.updatedAxes.reset();
+
+    for (uint32_t button{0}; button < m_numberOfButtons; button++) {
+        if (m_frame.updatedButtons.test(button)) {
+            events.buttons.set(button, m_frame.buttons.test(button));
+            events.buttonSampleTimesInMicroseconds[button] = sampleTimeInMicroseconds;
+        }
+    }
+    events.updatedButtons |= m_frame.updatedButtons;
+    m_frame.updatedButtons.reset();
+}
+
+void EvdevDevice::synchronize() noexcept {
+    for (uint32_t code{0}; code < ABS_CNT; code++) {
+        if ( (-1 < m_axisNumber[code]) && (0 == ::ioctl(m_fd, EVIOCGABS(code), &m_axisRange[code])) ) {
+            const std::size_t AXIS{static_cast<std::size_t>(m_axisNumber[code])};
+            m_frame.axisValues[AXIS] = scale(static_cast<uint16_t>(code), m_axisRange[code].value);
+            m_frame.updatedAxes.set(AXIS);
+        }
+    }
+
+    uint8_t keyState[KEY_CNT / 8 + 1]{};
+    if (0 <= ::ioctl(m_fd, EVIOCGKEY(sizeof(keyState)), keyState)) {
+        for (uint32_t code{0}; code < KEY_CNT; code++) {
+            if (-1 < m_buttonNumber[code]) {
+                const std::size_t BUTTON{static_cast<std::size_t>(m_buttonNumber[code])};
+                m_frame.buttons.set(BUTTON, isBitSet(keyState, code));
+                m_frame.updatedButtons.set(BUTTON);
+            }
+        }
+    }
+}
+
+int16_t EvdevDevice::scale(uint16_t code, int32_t value) const noexcept {
+    const struct input_absinfo &RANGE = m_axisRange[code];
+    const int64_t SCALED{(static_cast<int64_t>(value) - RANGE.minimum) * 65535 / (static_cast<int64_t>(RANGE.maximum) - RANGE.minimum) - 32768};
+    return static_cast<int16_t>((SCALED < -32768) ? -32768 : ((SCALED > 32767) ? 32767 : SCALED));
+}
+
+int64_t EvdevDevice::toMicroseconds(const struct input_event &ev) const noexcept {
+    int64_t timeInMicroseconds{static_cast<int64_t>(ev.input_event_sec) * 1000 * 1000 + static_cast<int64_t>(ev.input_event_usec)};
+    if (m_isMonotonicClock) {
+        // Move the monotonic capture time onto the wall clock used by cluon::data::TimeStamp.
+        struct timespec realtime{};
+        struct timespec monotonic{};
+        ::clock_gettime(CLOCK_REALTIME, &realtime);
+        ::clock_gettime(CLOCK_MONOTONIC, &monotonic);
+        timeInMicroseconds += timespecToMicroseconds(realtime) - timespecToMicroseconds(monotonic);
+    }
+    return timeInMicroseconds;
+}
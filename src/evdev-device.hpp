@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EVDEV_DEVICE_HPP
+#define EVDEV_DEVICE_HPP
+
+#include "input-device.hpp"
+
+#include <linux/input.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/**
+ * This class reads a controller using evdev (/dev/input/eventN). Axes are
+ * numbered and scaled like the joystick API does so that both backends are
+ * interchangeable; values are only handed out per complete SYN_REPORT and
+ * carry the kernel's microsecond capture time.
+ */
+class EvdevDevice : public InputDevice {
+   private:
+    EvdevDevice(const EvdevDevice &) = delete;
+    EvdevDevice(EvdevDevice &&)      = delete;
+    EvdevDevice &operator=(const EvdevDevice &) = delete;
+    EvdevDevice &operator=(EvdevDevice &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param fd Opened file descriptor of the device; it is owned and closed by this instance.
+     */
+    explicit EvdevDevice(int fd) noexcept;
+    ~EvdevDevice() override;
+
+   public:
+    std::string name() const noexcept override;
+    uint32_t numberOfAxes() const noexcept override;
+    uint32_t numberOfButtons() const noexcept override;
+    int fileDescriptor() const noexcept override;
+    bool read(InputEvents &events) noexcept override;
+
+   private:
+    /**
+     * This method reads the current values of all axes and buttons after the kernel dropped events.
+     */
+    void synchronize() noexcept;
+
+    /**
+     * This method hands out the values of the completed frame.
+     */
+    void commit(InputEvents &events, int64_t sampleTimeInMicroseconds) noexcept;
+
+    int16_t scale(uint16_t code, int32_t value) const noexcept;
+    int64_t toMicroseconds(const struct input_event &ev) const noexcept;
+
+   private:
+    enum { EVENTS_PER_READ = 64 };
+
+    int m_fd{-1};
+    std::string m_name{"Unknown"};
+    uint32_t m_numberOfAxes{0};
+    uint32_t m_numberOfButtons{0};
+    bool m_isMonotonicClock{false};
+
+    // Joystick API axis number and range per ABS code; -1 for unused codes.
+    std::array<int16_t, ABS_CNT> m_axisNumber{};
+    std::array<struct input_absinfo, ABS_CNT> m_axisRange{};
+
+    // Joystick API button number per KEY code; -1 for unused codes.
+    std::array<int16_t, KEY_CNT> m_buttonNumber{};
+
+    // Values of the SYN_REPORT frame that is currently being read.
+    InputEvents m_frame{};
+    bool m_isDropping{false};
+    bool m_needsSynchronization{true};
+
+    struct input_event m_events[EVENTS_PER_READ]{};
+};
+
+#endif
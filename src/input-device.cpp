@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input-device.hpp"
+#include "evdev-device.hpp"
+#include "joystick-device.hpp"
+
+#include <linux/input.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+std::unique_ptr<InputDevice> openInputDevice(const std::string &device, bool reportErrors) noexcept {
+    std::unique_ptr<InputDevice> retVal{nullptr};
+    int fd{-1};
+    if ( -1 == (fd = ::open(device.c_str(), O_RDONLY | O_CLOEXEC)) ) {
+        if (reportErrors) {
+            std::cerr << "[opendlv-device-ps3controller]: Could not open device: " << device << ", error: " << errno << ": " << strerror(errno) << std::endl;
+        }
+    }
+    else {
+        // Only evdev devices answer EVIOCGVERSION.
+        int version{0};
+        if (0 == ::ioctl(fd, EVIOCGVERSION, &version)) {
+            retVal.reset(new EvdevDevice(fd));
+        }
+        else {
+            retVal.reset(new JoystickDevice(fd));
+        }
+    }
+    return retVal;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INPUT_DEVICE_HPP
+#define INPUT_DEVICE_HPP
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * Raw values decoded from a controller. Axis values use the range of the
+ * joystick API [-32768, 32767] regardless of the backend; axes and buttons
+ * are numbered like the joystick API does.
+ */
+struct InputEvents {
+    enum : std::size_t { MAX_NUMBER_OF_AXES = 256, MAX_NUMBER_OF_BUTTONS = 512 };
+
+    std::array<int16_t, MAX_NUMBER_OF_AXES> axisValues{};
+    std::bitset<MAX_NUMBER_OF_AXES> updatedAxes{};
+
+    // Time point in microseconds since epoch when each axis value was captured; 0 if unknown.
+    std::array<int64_t, MAX_NUMBER_OF_AXES> axisSampleTimesInMicroseconds{};
+
+    // Set bits denote pressed buttons.
+    std::bitset<MAX_NUMBER_OF_BUTTONS> buttons{};
+    std::bitset<MAX_NUMBER_OF_BUTTONS> updatedButtons{};
+
+    // Time point in microseconds since epoch when each button was pressed or released; 0 if unknown.
+    std::array<int64_t, MAX_NUMBER_OF_BUTTONS> buttonSampleTimesInMicroseconds{};
+
+    // Number of events read from the device; reset by the caller.
+    uint32_t numberOfEvents{0};
+};
+
+/**
+ * Interface for controller backends.
+ */
+class InputDevice {
+   public:
+    virtual ~InputDevice() = default;
+
+    /**
+     * @return Name of the controller.
+     */
+    virtual std::string name() const noexcept = 0;
+
+    /**
+     * @return Number of axes.
+     */
+    virtual uint32_t numberOfAxes() const noexcept = 0;
+
+    /**
+     * @return Number of buttons.
+     */
+    virtual uint32_t numberOfButtons() const noexcept = 0;
+
+    /**
+     * @return Non-blocking file descriptor to wait on for new events.
+     */
+    virtual int fileDescriptor() const noexcept = 0;
+
+    /**
+     * This method reads all pending events without blocking.
+     *
+     * @param events Raw values to update.
+     * @return false if the device cannot be read anymore.
+     */
+    virtual bool read(InputEvents &events) noexcept = 0;
+};
+
+/**
+ * This method opens the given device: evdev devices (/dev/input/eventN) are
+ * read with their own backend, all other ones using the joystick API.
+ *
+ * @param device Path to the device.
+ * @param reportErrors false to not report a failure, e.g. while waiting for the device to reconnect.
+ * @return Opened device or nullptr.
+ */
+std::unique_ptr<InputDevice> openInputDevice(const std::string &device, bool reportErrors = true) noexcept;
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "joystick-device.hpp"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+JoystickDevice::JoystickDevice(int fd) noexcept
+    : m_fd{fd} {
+    int num_of_axes{0};
+    int num_of_buttons{0};
+    char name_of_ps3controller[80];
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverflow"
+    ::ioctl(m_fd, JSIOCGAXES, &num_of_axes);
+    ::ioctl(m_fd, JSIOCGBUTTONS, &num_of_buttons);
+#pragma GCC diagnostic pop
+    if (::ioctl(m_fd, JSIOCGNAME(80), &name_of_ps3controller) < 0) {
+        ::strncpy(name_of_ps3controller, "Unknown", sizeof(name_of_ps3controller));
+    }
+    name_of_ps3controller[sizeof(name_of_ps3controller) - 1] = '\0';
+    m_name = std::string(name_of_ps3controller);
+    m_numberOfAxes = static_cast<uint32_t>(num_of_axes);
+    m_numberOfButtons = static_cast<uint32_t>(num_of_buttons);
+
+    // Use non blocking reading.
+    ::fcntl(m_fd, F_SETFL, O_NONBLOCK);
+}
+
+JoystickDevice::~JoystickDevice() {
+    ::close(m_fd);
+}
+
+std::string JoystickDevice::name() const noexcept {
+    return m_name;
+}
+
+uint32_t JoystickDevice::numberOfAxes() const noexcept {
+    return m_numberOfAxes;
+}
+
+uint32_t JoystickDevice::numberOfButtons() const noexcept {
+    return m_numberOfButtons;
+}
+
+int JoystickDevice::fileDescriptor() const noexcept {
+    return m_fd;
+}
+
+bool JoystickDevice::read(InputEvents &events) noexcept {
+    // Drain all pending events with as few read calls as possible; a read
+    // returning less than a full buffer means that the queue is empty.
+    ssize_t bytesRead{0};
+    do {
+        bytesRead = ::read(m_fd, m_events, sizeof(m_events));
+        const int64_t NOW{std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count()};
+        const std::size_t NUMBER_OF_JS_EVENTS{(0 < bytesRead) ? static_cast<std::size_t>(bytesRead) / sizeof(struct js_event) : 0};
+        events.numberOfEvents += static_cast<uint32_t>(NUMBER_OF_JS_EVENTS);
+        for (std::size_t i{0}; i < NUMBER_OF_JS_EVENTS; i++) {
+            const struct js_event &js = m_events[i];
+            switch (js.type & ~JS_EVENT_INIT) {
+                case JS_EVENT_AXIS:
+                    events.axisValues[js.number] = js.value;
+                    events.axisSampleTimesInMicroseconds[js.number] = toMicroseconds(js.time, NOW);
+                    events.updatedAxes.set(js.number);
+                    break;
+                case JS_EVENT_BUTTON:
+                    events.buttons.set(js.number, 0 != js.value);
+                    events.buttonSampleTimesInMicroseconds[js.number] = toMicroseconds(js.time, NOW);
+                    events.updatedButtons.set(js.number);
+                    break;
+                default:
+                    break;
+            }
+        }
+    } while (static_cast<ssize_t>(sizeof(m_events)) == bytesRead);
+
+    bool retVal{true};
+    if ( (0 > bytesRead) && (errno != EAGAIN) ) {
+        std::cerr << "[opendlv-device-ps3controller]: Error: " << errno << ": " << strerror(errno) << std::endl;
+        retVal = false;
+    }
+    return retVal;
+}
+
+int64_t JoystickDevice::toMicroseconds(uint32_t time, int64_t nowInMicroseconds) noexcept {
+    // The kernel stamps js_events in milliseconds on its own wrapping clock.
+    // The smallest difference to the wall clock seen so far belongs to the
+    // event read with the least delay and serves as offset between both.
+    const uint32_t NOW_IN_MILLISECONDS{static_cast<uint32_t>(nowInMicroseconds / 1000)};
+    const uint32_t DIFFERENCE{NOW_IN_MILLISECONDS - time};
+    if (!m_hasClockOffset || (static_cast<int32_t>(DIFFERENCE - m_clockOffset) < 0)) {
+        m_clockOffset = DIFFERENCE;
+        m_hasClockOffset = true;
+    }
+    const uint32_t AGE_IN_MILLISECONDS{DIFFERENCE - m_clockOffset};
+    return nowInMicroseconds - static_cast<int64_t>(AGE_IN_MILLISECONDS) * 1000;
+}
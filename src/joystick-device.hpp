@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOYSTICK_DEVICE_HPP
+#define JOYSTICK_DEVICE_HPP
+
+#include "input-device.hpp"
+
+#include <linux/joystick.h>
+
+#include <cstdint>
+#include <string>
+
+/**
+ * This class reads a controller using the joystick API (/dev/input/jsN).
+ */
+class JoystickDevice : public InputDevice {
+   private:
+    JoystickDevice(const JoystickDevice &) = delete;
+    JoystickDevice(JoystickDevice &&)      = delete;
+    JoystickDevice &operator=(const JoystickDevice &) = delete;
+    JoystickDevice &operator=(JoystickDevice &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param fd Opened file descriptor of the device; it is owned and closed by this instance.
+     */
+    explicit JoystickDevice(int fd) noexcept;
+    ~JoystickDevice() override;
+
+   public:
+    std::string name() const noexcept override;
+    uint32_t numberOfAxes() const noexcept override;
+    uint32_t numberOfButtons() const noexcept override;
+    int fileDescriptor() const noexcept override;
+    bool read(InputEvents &events) noexcept override;
+
+   private:
+    /**
+     * This method maps a js_event's millisecond time onto the wall clock.
+     *
+     * @param time js_event's time.
+     * @param nowInMicroseconds Time point when the event was read.
+     * @return Time point in microseconds since epoch when the event was captured.
+     */
+    int64_t toMicroseconds(uint32_t time, int64_t nowInMicroseconds) noexcept;
+
+   private:
+    enum { EVENTS_PER_READ = 64 };
+
+    int m_fd{-1};
+    std::string m_name{"Unknown"};
+    uint32_t m_numberOfAxes{0};
+    uint32_t m_numberOfButtons{0};
+    bool m_hasClockOffset{false};
+    uint32_t m_clockOffset{0};
+    struct js_event m_events[EVENTS_PER_READ]{};
+};
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "latency-histogram.hpp"
+
+LatencyHistogram::LatencyHistogram() noexcept
+    : m_buckets() {
+    for (auto &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(uint64_t value) noexcept {
+    const uint32_t VALUE{(value > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(value)};
+    m_buckets[toBucket(VALUE)].fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t minimum{m_minimum.load(std::memory_order_relaxed)};
+    while ((VALUE < minimum) && !m_minimum.compare_exchange_weak(minimum, VALUE, std::memory_order_relaxed)) {}
+    uint32_t maximum{m_maximum.load(std::memory_order_relaxed)};
+    while ((VALUE > maximum) && !m_maximum.compare_exchange_weak(maximum, VALUE, std::memory_order_relaxed)) {}
+}
+
+LatencyHistogram::Summary LatencyHistogram::summarizeAndReset() noexcept {
+    std::array<uint32_t, NUMBER_OF_BUCKETS> counts{};
+    uint64_t total{0};
+    for (uint32_t i{0}; i < NUMBER_OF_BUCKETS; i++) {
+        counts[i] = m_buckets[i].exchange(0, std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    Summary summary;
+    summary.count = static_cast<uint32_t>(total);
+    summary.minimum = m_minimum.exchange(UINT32_MAX, std::memory_order_relaxed);
+    summary.maximum = m_maximum.exchange(0, std::memory_order_relaxed);
+    if (0 == total) {
+        summary.minimum = 0;
+    }
+    else {
+        struct {
+            uint64_t rank;
+            uint32_t *value;
+        } percentiles[] = {{(total * 500 + 999) / 1000, &summary.median},
+                           {(total * 900 + 999) / 1000, &summary.percentile90},
+                           {(total * 990 + 999) / 1000, &summary.percentile99},
+                           {(total * 999 + 999) / 1000, &summary.percentile999}};
+        uint64_t seen{0};
+        std::size_t next{0};
+        for (uint32_t i{0}; (i < NUMBER_OF_BUCKETS) && (next < sizeof(percentiles) / sizeof(percentiles[0])); i++) {
+            seen += counts[i];
+            while ((next < sizeof(percentiles) / sizeof(percentiles[0])) && (seen >= percentiles[next].rank)) {
+                // Report the bucket's highest value but never more than the exact maximum.
+                const uint32_t HIGHEST{highestValueOf(i)};
+                *percentiles[next].value = (HIGHEST < summary.maximum) ? HIGHEST : summary.maximum;
+                next++;
+            }
+        }
+    }
+    return summary;
+}
+
+uint32_t LatencyHistogram::toBucket(uint32_t value) noexcept {
+    uint32_t bucket{value};
+    if (value >= 2 * SUB_BUCKETS) {
+        const uint32_t MOST_SIGNIFICANT_BIT{31 - static_cast<uint32_t>(__builtin_clz(value))};
+        const uint32_t EXPONENT{MOST_SIGNIFICANT_BIT - SUB_BUCKET_BITS};
+        bucket = (EXPONENT + 1) * SUB_BUCKETS + (value >> EXPONENT) - SUB_BUCKETS;
+    }
+    return bucket;
+}
+
+uint32_t LatencyHistogram::highestValueOf(uint32_t bucket) noexcept {
+    uint32_t value{bucket};
+    if (bucket >= 2 * SUB_BUCKETS) {
+        const uint32_t EXPONENT{bucket / SUB_BUCKETS - 1};
+        const uint64_t LOWEST{static_cast<uint64_t>(bucket % SUB_BUCKETS + SUB_BUCKETS) << EXPONENT};
+        const uint64_t HIGHEST{LOWEST + (1ull << EXPONENT) - 1};
+        value = (HIGHEST > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(HIGHEST);
+    }
+    return value;
+}
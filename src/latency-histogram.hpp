@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * This class counts values in logarithmic buckets with linear sub-buckets
+ * (similar to an HDR histogram) so that percentiles are accurate to about
+ * 3% for values from 0 to 2^32-1. Recording is wait-free and can run
+ * concurrently with summarizing from another thread.
+ */
+class LatencyHistogram {
+   private:
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram(LatencyHistogram &&)      = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(LatencyHistogram &&) = delete;
+
+   public:
+    struct Summary {
+        uint32_t count{0};
+        uint32_t minimum{0};
+        uint32_t median{0};
+        uint32_t percentile90{0};
+        uint32_t percentile99{0};
+        uint32_t percentile999{0};
+        uint32_t maximum{0};
+    };
+
+   public:
+    LatencyHistogram() noexcept;
+    ~LatencyHistogram() = default;
+
+    /**
+     * This method records a value; larger values are counted as 2^32-1.
+     *
+     * @param value Value to record.
+     */
+    void record(uint64_t value) noexcept;
+
+    /**
+     * This method summarizes all values recorded since its last call and
+     * resets the histogram.
+     *
+     * @return Summary of the recorded values.
+     */
+    Summary summarizeAndReset() noexcept;
+
+   private:
+    enum : uint32_t {
+        SUB_BUCKET_BITS   = 5,
+        SUB_BUCKETS       = 1 << SUB_BUCKET_BITS,
+        NUMBER_OF_BUCKETS = (32 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS,
+    };
+
+    static uint32_t toBucket(uint32_t value) noexcept;
+    static uint32_t highestValueOf(uint32_t bucket) noexcept;
+
+   private:
+    std::array<std::atomic<uint32_t>, NUMBER_OF_BUCKETS> m_buckets;
+    std::atomic<uint32_t> m_minimum{UINT32_MAX};
+    std::atomic<uint32_t> m_maximum{0};
+};
+
+#endif
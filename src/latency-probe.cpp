@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "latency-probe.hpp"
+
+#include <algorithm>
+
+LatencyProbe::LatencyProbe(uint32_t firstSenderStamp, uint32_t numberOfControllers, int64_t echoSenderStamp) noexcept
+    : m_firstSenderStamp{firstSenderStamp}
+    , m_numberOfControllers{std::min<uint32_t>(numberOfControllers, MAX_NUMBER_OF_CONTROLLERS)}
+    , m_echoSenderStamp{echoSenderStamp} {
+}
+
+void LatencyProbe::sent(uint32_t senderStamp, int64_t sampleTimeInMicroseconds, int64_t sentTimeInMicroseconds) noexcept {
+    if (hasEcho()) {
+        std::lock_guard<std::mutex> lck(m_sentSamplesMutex);
+        SentSample &sample = m_sentSamples[m_nextSentSample];
+        sample.senderStamp = senderStamp;
+        sample.sampleTimeInMicroseconds = sampleTimeInMicroseconds;
+        sample.sentTimeInMicroseconds = sentTimeInMicroseconds;
+        sample.isEchoed = false;
+        m_nextSentSample = (m_nextSentSample + 1) % NUMBER_OF_SENT_SAMPLES;
+    }
+}
+
+void LatencyProbe::received(uint32_t senderStamp, int64_t sampleTimeInMicroseconds, int64_t sentTimeInMicroseconds, int64_t receivedTimeInMicroseconds) noexcept {
+    if (hasEcho() && (static_cast<int64_t>(senderStamp) == m_echoSenderStamp)) {
+        std::lock_guard<std::mutex> lck(m_sentSamplesMutex);
+        for (SentSample &sample : m_sentSamples) {
+            if (!sample.isEchoed && (0 != sample.sampleTimeInMicroseconds) && (sample.sampleTimeInMicroseconds == sampleTimeInMicroseconds)) {
+                sample.isEchoed = true;
+                m_roundTripLatency.record(static_cast<uint64_t>(std::max<int64_t>(receivedTimeInMicroseconds - sample.sentTimeInMicroseconds, 0)));
+                break;
+            }
+        }
+    }
+    else if ( (senderStamp >= m_firstSenderStamp) && (senderStamp - m_firstSenderStamp < m_numberOfControllers) && (sampleTimeInMicroseconds != sentTimeInMicroseconds) ) {
+        // Messages without captured values, like the stops, carry their sent time as sample time.
+        // Repeated messages carry the same sample and would only measure its age.
+        int64_t &lastReceivedSampleTime = m_lastReceivedSampleTimes[senderStamp - m_firstSenderStamp];
+        if (lastReceivedSampleTime != sampleTimeInMicroseconds) {
+            lastReceivedSampleTime = sampleTimeInMicroseconds;
+            m_inputToReceiveLatency.record(static_cast<uint64_t>(std::max<int64_t>(receivedTimeInMicroseconds - sampleTimeInMicroseconds, 0)));
+            m_sendToReceiveLatency.record(static_cast<uint64_t>(std::max<int64_t>(receivedTimeInMicroseconds - sentTimeInMicroseconds, 0)));
+        }
+    }
+}
+
+bool LatencyProbe::hasEcho() const noexcept {
+    return 0 <= m_echoSenderStamp;
+}
+
+LatencyHistogram &LatencyProbe::inputToReceiveLatency() noexcept {
+    return m_inputToReceiveLatency;
+}
+
+LatencyHistogram &LatencyProbe::sendToReceiveLatency() noexcept {
+    return m_sendToReceiveLatency;
+}
+
+LatencyHistogram &LatencyProbe::roundTripLatency() noexcept {
+    return m_roundTripLatency;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LATENCY_PROBE_HPP
+#define LATENCY_PROBE_HPP
+
+#include "latency-histogram.hpp"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * This class correlates the ActuationRequest messages received from the
+ * OD4Session with the ones sent before. As these messages carry no sequence
+ * number, a sent message is identified by its sender stamp and the sample
+ * time stamp holding the capture time of the controller's values:
+ *
+ * - Own messages are received via multicast loopback and measure the time
+ *   from capturing the values to receiving them and from sending to receiving.
+ * - Echoes are ActuationRequest messages that a cooperating gateway sends
+ *   back with its own sender stamp but the original sample time stamp; they
+ *   measure the round trip from sending to receiving the echo.
+ *
+ * Only the first received message carrying a new sample is measured. sent is
+ * called from the sending and the reading thread and received from the
+ * OD4Session's thread.
+ */
+class LatencyProbe {
+   private:
+    LatencyProbe(const LatencyProbe &) = delete;
+    LatencyProbe(LatencyProbe &&)      = delete;
+    LatencyProbe &operator=(const LatencyProbe &) = delete;
+    LatencyProbe &operator=(LatencyProbe &&) = delete;
+
+   public:
+    enum : uint32_t { MAX_NUMBER_OF_CONTROLLERS = 64 };
+
+    /**
+     * Constructor.
+     *
+     * @param firstSenderStamp Sender stamp of the first controller.
+     * @param numberOfControllers Number of controllers with consecutive sender stamps.
+     * @param echoSenderStamp Sender stamp of the gateway's echoes; negative to measure own messages only.
+     */
+    LatencyProbe(uint32_t firstSenderStamp, uint32_t numberOfControllers, int64_t echoSenderStamp) noexcept;
+    ~LatencyProbe() = default;
+
+    /**
+     * This method remembers a message sent with a new sample.
+     *
+     * @param senderStamp Sender stamp of the message.
+     * @param sampleTimeInMicroseconds Sample time stamp of the message.
+     * @param sentTimeInMicroseconds Time point of sending.
+     */
+    void sent(uint32_t senderStamp, int64_t sampleTimeInMicroseconds, int64_t sentTimeInMicroseconds) noexcept;
+
+    /**
+     * This method measures a received ActuationRequest message.
+     *
+     * @param senderStamp Sender stamp of the message.
+     * @param sampleTimeInMicroseconds Sample time stamp of the message.
+     * @param sentTimeInMicroseconds Sent time stamp of the message.
+     * @param receivedTimeInMicroseconds Time point of receiving.
+     */
+    void received(uint32_t senderStamp, int64_t sampleTimeInMicroseconds, int64_t sentTimeInMicroseconds, int64_t receivedTimeInMicroseconds) noexcept;
+
+    /**
+     * @return true if echoes are measured.
+     */
+    bool hasEcho() const noexcept;
+
+    /**
+     * @return Time from capturing the values to receiving the own message in microseconds.
+     */
+    LatencyHistogram &inputToReceiveLatency() noexcept;
+
+    /**
+     * @return Time from sending to receiving the own message in microseconds.
+     */
+    LatencyHistogram &sendToReceiveLatency() noexcept;
+
+    /**
+     * @return Time from sending to receiving the gateway's echo in microseconds.
+     */
+    LatencyHistogram &roundTripLatency() noexcept;
+
+   private:
+    enum : uint32_t { NUMBER_OF_SENT_SAMPLES = 256 };
+
+    struct SentSample {
+        uint32_t senderStamp{0};
+        int64_t sampleTimeInMicroseconds{0};
+        int64_t sentTimeInMicroseconds{0};
+        bool isEchoed{false};
+    };
+
+    uint32_t m_firstSenderStamp;
+    uint32_t m_numberOfControllers;
+    int64_t m_echoSenderStamp;
+
+    // Recently sent samples to look up the echoes in.
+    std::mutex m_sentSamplesMutex{};
+    std::array<SentSample, NUMBER_OF_SENT_SAMPLES> m_sentSamples{};
+    uint32_t m_nextSentSample{0};
+
+    // Sample time stamp of the last measured own message per controller.
+    std::array<int64_t, MAX_NUMBER_OF_CONTROLLERS> m_lastReceivedSampleTimes{};
+
+    LatencyHistogram m_inputToReceiveLatency{};
+    LatencyHistogram m_sendToReceiveLatency{};
+    LatencyHistogram m_roundTripLatency{};
+};
+
+#endif
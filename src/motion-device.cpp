@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "motion-device.hpp"
+
+#include <endian.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+
+// Older kernel headers only provide the timeval member.
+#ifndef input_event_sec
+    #define input_event_sec time.tv_sec
+    #define input_event_usec time.tv_usec
+#endif
+
+namespace {
+    bool isBitSet(const uint8_t *bits, uint32_t bit) noexcept {
+        return 0 != (bits[bit / 8] & (1u << (bit % 8)));
+    }
+
+    int64_t timespecToMicroseconds(const struct timespec &ts) noexcept {
+        return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 + static_cast<int64_t>(ts.tv_nsec) / 1000;
+    }
+}
+
+MotionDevice::MotionDevice(int fd, uint32_t samplesPerBatch, std::function<void(const MotionBatch &)> delegate) noexcept
+    : m_fd{fd}
+    , m_samplesPerBatch{(0 < samplesPerBatch) ? samplesPerBatch : 1}
+    , m_delegate{delegate} {
+    char name_of_device[80];
+    if (::ioctl(m_fd, EVIOCGNAME(sizeof(name_of_device)), name_of_device) < 0) {
+        ::strncpy(name_of_device, "Unknown", sizeof(name_of_device));
+    }
+    name_of_device[sizeof(name_of_device) - 1] = '\0';
+    m_name = std::string(name_of_device);
+
+    // Prefer timestamps that are not affected by changes of the wall clock.
+    int clockId{CLOCK_MONOTONIC};
+    m_isMonotonicClock = (0 == ::ioctl(m_fd, EVIOCSCLOCKID, &clockId));
+
+    uint8_t absBits[ABS_CNT / 8 + 1]{};
+    ::ioctl(m_fd, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits);
+    m_axisNumber.fill(-1);
+    for (uint32_t code{0}; (code < ABS_CNT) && (m_numberOfAxes < MAX_NUMBER_OF_AXES); code++) {
+        if (isBitSet(absBits, code) && (0 == ::ioctl(m_fd, EVIOCGABS(code), &m_axisRange[code])) && (m_axisRange[code].maximum > m_axisRange[code].minimum)) {
+            m_values[m_numberOfAxes] = scale(static_cast<uint16_t>(code), m_axisRange[code].value);
+            m_axisNumber[code] = static_cast<int16_t>(m_numberOfAxes++);
+        }
+    }
+
+    m_batch.numberOfAxes = m_numberOfAxes;
+    m_batch.samples.reserve(2 * m_numberOfAxes * m_samplesPerBatch);
+
+    // Use non blocking reading.
+    ::fcntl(m_fd, F_SETFL, O_NONBLOCK);
+}
+
+MotionDevice::~MotionDevice() {
+    ::close(m_fd);
+}
+
+std::string MotionDevice::name() const noexcept {
+    return m_name;
+}
+
+uint32_t MotionDevice::numberOfAxes() const noexcept {
+    return m_numberOfAxes;
+}
+
+std::string MotionDevice::describeAxes() const noexcept {
+    std::stringstream sstr;
+    for (uint32_t code{0}; code < ABS_CNT; code++) {
+        if (-1 < m_axisNumber[code]) {
+            const struct input_absinfo &RANGE = m_axisRange[code];
+            sstr << ((0 < m_axisNumber[code]) ? ", " : "") << "axis " << m_axisNumber[code] << ": code " << code << ", range ["
+                 << RANGE.minimum << ", " << RANGE.maximum << "], resolution " << RANGE.resolution;
+        }
+    }
+    return sstr.str();
+}
+
+int MotionDevice::fileDescriptor() const noexcept {
+    return m_fd;
+}
+
+uint64_t MotionDevice::drops() const noexcept {
+    return m_drops;
+}
+
+bool MotionDevice::read() noexcept {
+    ssize_t bytesRead{0};
+    do {
+        bytesRead = ::read(m_fd, m_events, sizeof(m_events));
+        const std::size_t NUMBER_OF_EVENTS{(0 < bytesRead) ? static_cast<std::size_t>(bytesRead) / sizeof(struct input_event) : 0};
+        for (std::size_t i{0}; i < NUMBER_OF_EVENTS; i++) {
+            const struct input_event &ev = m_events[i];
+            if ( (EV_SYN == ev.type) && (SYN_REPORT == ev.code) ) {
+                if (m_isDropping) {
+                    // The frame following SYN_DROPPED is incomplete; continue with the current values.
+                    for (uint32_t code{0}; code < ABS_CNT; code++) {
+                        if ( (-1 < m_axisNumber[code]) && (0 == ::ioctl(m_fd, EVIOCGABS(code), &m_axisRange[code])) ) {
+                            m_values[static_cast<std::size_t>(m_axisNumber[code])] = scale(static_cast<uint16_t>(code), m_axisRange[code].value);
+                        }
+                    }
+                    m_isDropping = false;
+                    continue;
+                }
+
+                const int64_t SAMPLE_TIME_IN_MICROSECONDS{toMicroseconds(ev)};
+                if (0 == m_batch.numberOfSamples) {
+                    m_batch.firstSampleTimeInMicroseconds = SAMPLE_TIME_IN_MICROSECONDS;
+                }
+                m_batch.lastSampleTimeInMicroseconds = SAMPLE_TIME_IN_MICROSECONDS;
+                for (uint32_t axis{0}; axis < m_numberOfAxes; axis++) {
+                    const uint16_t VALUE{htole16(static_cast<uint16_t>(m_values[axis]))};
+                    m_batch.samples.append(reinterpret_cast<const char *>(&VALUE), sizeof(VALUE));
+                }
+                if (++m_batch.numberOfSamples == m_samplesPerBatch) {
+                    flush();
+                }
+            }
+            else if ( (EV_SYN == ev.type) && (SYN_DROPPED == ev.code) ) {
+                m_isDropping = true;
+                m_drops++;
+            }
+            else if ( !m_isDropping && (EV_ABS == ev.type) && (ev.code < ABS_CNT) && (-1 < m_axisNumber[ev.code]) ) {
+                m_values[static_cast<std::size_t>(m_axisNumber[ev.code])] = scale(ev.code, ev.value);
+            }
+        }
+    } while (static_cast<ssize_t>(sizeof(m_events)) == bytesRead);
+
+    bool retVal{true};
+    if ( (0 > bytesRead) && (errno != EAGAIN) ) {
+        std::cerr << "[opendlv-device-ps3controller]: Error: " << errno << ": " << strerror(errno) << std::endl;
+        retVal = false;
+    }
+    return retVal;
+}
+
+void MotionDevice::flush() noexcept {
+    if (0 < m_batch.numberOfSamples) {
+        if (nullptr != m_delegate) {
+            m_delegate(m_batch);
+        }
+        m_batch.numberOfSamples = 0;
+        m_batch.samples.clear();
+    }
+}
+
+int16_t MotionDevice::scale(uint16_t code, int32_t value) const noexcept {
+    const struct input_absinfo &RANGE = m_axisRange[code];
+    const int64_t SCALED{(static_cast<int64_t>(value) - RANGE.minimum) * 65535 / (static_cast<int64_t>(RANGE.maximum) - RANGE.minimum) - 32768};
+    return static_cast<int16_t>((SCALED < -32768) ? -32768 : ((SCALED > 32767) ? 32767 : SCALED));
+}
+
+int64_t MotionDevice::toMicroseconds(const struct input_event &ev) const noexcept {
+    int64_t timeInMicroseconds{static_cast<int64_t>(ev.input_event_sec) * 1000 * 1000 + static_cast<int64_t>(ev.input_event_usec)};
+    if (m_isMonotonicClock) {
+        // Move the monotonic capture time onto the wall clock used by cluon::data::TimeStamp.
+        struct timespec realtime{};
+        struct timespec monotonic{};
+        ::clock_gettime(CLOCK_REALTIME, &realtime);
+        ::clock_gettime(CLOCK_MONOTONIC, &monotonic);
+        timeInMicroseconds += timespecToMicroseconds(realtime) - timespecToMicroseconds(monotonic);
+    }
+    return timeInMicroseconds;
+}
+
+std::unique_ptr<MotionDevice> openMotionDevice(const std::string &device, uint32_t samplesPerBatch, std::function<void(const MotionBatch &)> delegate, bool reportErrors) noexcept {
+    std::unique_ptr<MotionDevice> retVal{nullptr};
+    int fd{-1};
+    int version{0};
+    if ( -1 == (fd = ::open(device.c_str(), O_RDONLY | O_CLOEXEC)) ) {
+        if (reportErrors) {
+            std::cerr << "[opendlv-device-ps3controller]: Could not open motion device: " << device << ", error: " << errno << ": " << strerror(errno) << std::endl;
+        }
+    }
+    else if (0 != ::ioctl(fd, EVIOCGVERSION, &version)) {
+        // Only evdev devices answer EVIOCGVERSION.
+        std::cerr << "[opendlv-device-ps3controller]: Motion device " << device << " is not an evdev device (/dev/input/eventN)." << std::endl;
+        ::close(fd);
+    }
+    else {
+        retVal.reset(new MotionDevice(fd, samplesPerBatch, delegate));
+        if (0 == retVal->numberOfAxes()) {
+            std::cerr << "[opendlv-device-ps3controller]: Motion device " << device << " has no axes." << std::endl;
+            retVal.reset();
+        }
+    }
+    return retVal;
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MOTION_DEVICE_HPP
+#define MOTION_DEVICE_HPP
+
+#include <linux/input.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+/**
+ * Samples of a motion sensor collected into one batch.
+ */
+struct MotionBatch {
+    // Time points in microseconds since epoch of capturing the first and last sample.
+    int64_t firstSampleTimeInMicroseconds{0};
+    int64_t lastSampleTimeInMicroseconds{0};
+    uint32_t numberOfAxes{0};
+    uint32_t numberOfSamples{0};
+    // Values of all axes as little endian int16, one sample after the other.
+    std::string samples{};
+};
+
+/**
+ * This class reads the motion sensors of a controller that the kernel
+ * exposes as evdev device of its own (like "Sony PLAYSTATION(R)3 Controller
+ * Motion Sensors"). Unlike EvdevDevice, which only hands out the latest
+ * values, each SYN_REPORT frame is kept as one sample so that the sensors'
+ * native rate is preserved; the samples are collected into batches of a
+ * fixed size that are handed to a delegate. Axes are numbered in ascending
+ * order of their ABS codes and scaled from their range to [-32768, 32767].
+ */
+class MotionDevice {
+   private:
+    MotionDevice(const MotionDevice &) = delete;
+    MotionDevice(MotionDevice &&)      = delete;
+    MotionDevice &operator=(const MotionDevice &) = delete;
+    MotionDevice &operator=(MotionDevice &&) = delete;
+
+   public:
+    enum : uint32_t { MAX_NUMBER_OF_AXES = 16 };
+
+    /**
+     * Constructor.
+     *
+     * @param fd Opened file descriptor of the device; it is owned and closed by this instance.
+     * @param samplesPerBatch Number of samples per batch.
+     * @param delegate Function to call with each complete batch.
+     */
+    MotionDevice(int fd, uint32_t samplesPerBatch, std::function<void(const MotionBatch &)> delegate) noexcept;
+    ~MotionDevice();
+
+    /**
+     * @return Name of the device.
+     */
+    std::string name() const noexcept;
+
+    /**
+     * @return Number of axes of each sample.
+     */
+    uint32_t numberOfAxes() const noexcept;
+
+    /**
+     * @return Description of the range and resolution of all axes.
+     */
+    std::string describeAxes() const noexcept;
+
+    /**
+     * @return Non-blocking file descriptor to wait on for new samples.
+     */
+    int fileDescriptor() const noexcept;
+
+    /**
+     * @return Number of times the kernel dropped samples because they were not read in time.
+     */
+    uint64_t drops() const noexcept;
+
+    /**
+     * This method reads all pending samples without blocking and hands out
+     * each batch that got complete.
+     *
+     * @return false if the device cannot be read anymore.
+     */
+    bool read() noexcept;
+
+    /**
+     * This method hands out the incomplete batch, if any.
+     */
+    void flush() noexcept;
+
+   private:
+    int16_t scale(uint16_t code, int32_t value) const noexcept;
+    int64_t toMicroseconds(const struct input_event &ev) const noexcept;
+
+   private:
+    enum { EVENTS_PER_READ = 256 };
+
+    int m_fd{-1};
+    std::string m_name{"Unknown"};
+    uint32_t m_numberOfAxes{0};
+    bool m_isMonotonicClock{false};
+    uint32_t m_samplesPerBatch;
+    std::function<void(const MotionBatch &)> m_delegate;
+
+    // Axis number and range per ABS code; -1 for unused codes.
+    std::array<int16_t, ABS_CNT> m_axisNumber{};
+    std::array<struct input_absinfo, ABS_CNT> m_axisRange{};
+
+    // Values of the sample that is currently being read.
+    std::array<int16_t, MAX_NUMBER_OF_AXES> m_values{};
+    bool m_isDropping{false};
+    uint64_t m_drops{0};
+
+    MotionBatch m_batch{};
+    struct input_event m_events[EVENTS_PER_READ]{};
+};
+
+/**
+ * This method opens the motion sensors of a controller given as evdev device.
+ *
+ * @param device Path to the device.
+ * @param samplesPerBatch Number of samples per batch.
+ * @param delegate Function to call with each complete batch.
+ * @param reportErrors false to not report a failure to open, e.g. while waiting for the device to reconnect.
+ * @return Opened device or nullptr.
+ */
+std::unique_ptr<MotionDevice> openMotionDevice(const std::string &device, uint32_t samplesPerBatch, std::function<void(const MotionBatch &)> delegate, bool reportErrors = true) noexcept;
+
+#endif
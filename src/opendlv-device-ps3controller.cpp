@@ -17,29 +17,196 @@
 
 #include "cluon-complete.hpp"
 #include "actuationrequestmessage.hpp"
+#include "axis-filter.hpp"
+#include "axis-mapping.hpp"
+#include "batch-sender.hpp"
+#include "controller-profile.hpp"
+#include "controllereventmessage.hpp"
+#include "envelope-encoder.hpp"
+#include "gamepadstatemessage.hpp"
+#include "input-device.hpp"
+#include "latency-histogram.hpp"
+#include "latency-probe.hpp"
+#include "motion-device.hpp"
+#include "motionsamplesmessage.hpp"
+#include "periodic-scheduler.hpp"
+#include "readiness.hpp"
+#include "realtime.hpp"
+#include "recorder.hpp"
+#include "replay-device.hpp"
+#include "seqlock.hpp"
+#include "shared-controller-state.hpp"
+#include "statisticsmessage.hpp"
+#include "verbose-log.hpp"
 
-#include <linux/joystick.h>
-#include <fcntl.h>
-#include <sys/ioctl.h>
-#include <sys/socket.h>
-#include <sys/types.h>
+#include <glob.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
 #include <cerrno>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <sstream>
 #include <string>
 #include <thread>
+#include <vector>
+
+// Values read from the controller to be sent.
+struct ControllerState {
+    float acceleration{0};
+    float steering{0};
+    // Time point in microseconds when the values were captured; 0 if unknown.
+    int64_t sampleTimeInMicroseconds{0};
+    // false while the controller is disconnected.
+    bool isValid{true};
+};
+
+// Raw values of all axes and buttons to be sent as GamepadState.
+struct ControllerInputs {
+    // Bit n is set while button n is pressed.
+    uint64_t buttons{0};
+    // Time point in microseconds when the latest of the values was captured; 0 if unknown.
+    int64_t sampleTimeInMicroseconds{0};
+    uint16_t numberOfAxes{0};
+    uint16_t numberOfButtons{0};
+    std::array<int16_t, InputEvents::MAX_NUMBER_OF_AXES> axes{};
+};
+
+// State kept per controller.
+struct Controller {
+    std::string device{};
+    uint32_t senderStamp{0};
+    std::unique_ptr<InputDevice> inputDevice{};
+
+    // Used by the reading thread only.
+    InputEvents inputEvents{};
+    float acceleration{0};
+    float steering{0};
+    int64_t accelerationSampleTimeInMicroseconds{0};
+    int64_t steeringSampleTimeInMicroseconds{0};
+    int64_t sampleTimeInMicroseconds{0};
+    // Values that were last sent from the reading thread in on-change mode.
+    opendlv::proxy::ActuationRequest changedAr{};
+    // Time point of the last message sent from the reading thread; used to limit on-change
+    // sending to MAX_RATE independently of the repetitions sent by the sending thread.
+    int64_t lastChangeSentInMicroseconds{0};
+    // Set from pressing the emergency stop button until it is released with the acceleration at zero.
+    bool isEmergencyStopped{false};
+    // Filters the raw axis values if configured.
+    std::unique_ptr<AxisFilter> filter{};
+
+    // Values are handed over from the reading thread without locking.
+    SeqLock<ControllerState> state{};
+    SeqLock<ControllerInputs> inputs{};
+    // Slot in the shared memory area given with --shm; nullptr if not used.
+    cluon::SharedMemory *sharedMemory{nullptr};
+    SeqLock<SharedControllerState> *sharedState{nullptr};
+    uint64_t sharedSequenceNumber{0};
+
+    // Used by the sending thread only.
+    opendlv::proxy::ActuationRequest ar{};
+    uint32_t ticksSinceLastSend{0};
+    int64_t lastRecordedSampleTimeInMicroseconds{0};
+    int64_t lastSentInMicroseconds{0};
+    opendlv::proxy::GamepadState gamepadState{};
+    ControllerInputs sentInputs{};
+    std::string packedAxes{};
+};
+
+// Hands over the controller's values to the sending thread and to local readers of the shared memory area.
+void store(Controller &c, const ControllerState &state) noexcept {
+    c.state.store(state);
+    if (nullptr != c.sharedState) {
+        SharedControllerState shared;
+        shared.sequenceNumber = ++c.sharedSequenceNumber;
+        shared.sampleTimeInMicroseconds = state.sampleTimeInMicroseconds;
+        shared.writtenTimeInMicroseconds = cluon::time::toMicroseconds(cluon::time::now());
+        shared.senderStamp = c.senderStamp;
+        shared.acceleration = state.acceleration;
+        shared.steering = state.steering;
+        shared.isValid = (state.isValid ? 1 : 0);
+        c.sharedState->store(shared);
+        c.sharedMemory->notifyAll();
+    }
+}
+
+// Checks the response curve of the axis with the given argument prefix; see AxisMapping::Curve.
+bool isValidCurve(std::map<std::string, std::string> &commandlineArguments, const std::string &prefix) noexcept {
+    bool retVal{true};
+    auto check = [&commandlineArguments, &retVal](const std::string &name, float minimum, float maximum, bool isMaximumIncluded, const std::string &expected) {
+        if (commandlineArguments.count(name) != 0) {
+            const float VALUE{std::stof(commandlineArguments[name])};
+            if ( !std::isfinite(VALUE) || (VALUE < minimum) || (VALUE > maximum) || (!isMaximumIncluded && (VALUE >= maximum)) ) {
+                std::cerr << "[opendlv-device-ps3controller]: Invalid response curve: --" << name << "=" << commandlineArguments[name] << " (expected " << expected << ")." << std::endl;
+                retVal = false;
+            }
+        }
+    };
+    check(prefix + "_deadzone", 0.0f, 1.0f, false, "[0, 1)");
+    check(prefix + "_expo", 0.0f, 1.0f, true, "[0, 1]");
+    check(prefix + "_step", 0.0f, std::numeric_limits<float>::max(), true, "0 to disable rounding or a positive step");
+    return retVal;
+}
+
+// Expands a comma separated list of devices and glob patterns like /dev/input/js*.
+std::vector<std::string> listDevices(const std::string &devices) noexcept {
+    std::vector<std::string> retVal;
+    std::stringstream sstr{devices};
+    std::string pattern;
+    while (std::getline(sstr, pattern, ',')) {
+        if (pattern.empty()) {
+            continue;
+        }
+        // Patterns without matches are kept to report them when opening.
+        glob_t matches{};
+        if (0 == ::glob(pattern.c_str(), GLOB_NOCHECK, nullptr, &matches)) {
+            for (std::size_t i{0}; i < matches.gl_pathc; i++) {
+                retVal.push_back(matches.gl_pathv[i]);
+            }
+        }
+        ::globfree(&matches);
+    }
+    return retVal;
+}
 
 int32_t main(int32_t argc, char **argv) {
+    // The duration of the startup phases is logged once the first message was sent periodically.
+    const std::chrono::steady_clock::time_point START{std::chrono::steady_clock::now()};
+    auto elapsedInMicroseconds = [&START]() {
+        return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - START).count());
+    };
+
     int32_t retCode{0};
     auto commandlineArguments = cluon::getCommandlineArguments(argc, argv);
+    const std::string PUBLISH{(commandlineArguments.count("publish") != 0) ? commandlineArguments["publish"] : "periodic"};
+    // The layout of the controllers is resolved once; --ps4 is kept for compatibility.
+    const std::pair<bool, ControllerProfile> PROFILE{loadControllerProfile((commandlineArguments.count("profile") != 0) ? commandlineArguments["profile"]
+                                                                            : ((commandlineArguments.count("ps4") != 0) ? "ps4" : "ps3"))};
+    // Envelopes are sent to the OD4Session's multicast group or to a gateway given as udp:<host>:<port> or tcp:<host>:<port>.
+    const std::string TRANSPORT{(commandlineArguments.count("transport") != 0) ? commandlineArguments["transport"] : "multicast"};
+    const std::size_t PORT_SEPARATOR{TRANSPORT.rfind(':')};
+    const bool IS_UNICAST{((0 == TRANSPORT.find("udp:")) || (0 == TRANSPORT.find("tcp:"))) && (4 < PORT_SEPARATOR) &&
+                          (PORT_SEPARATOR + 1 < TRANSPORT.size()) && (std::string::npos == TRANSPORT.find_first_not_of("0123456789", PORT_SEPARATOR + 1))};
     if ( (0 == commandlineArguments.count("cid")) ||
-         (0 == commandlineArguments.count("device")) ||
-         (0 == commandlineArguments.count("freq")) ||
+         ((0 == commandlineArguments.count("device")) && (0 == commandlineArguments.count("replay"))) ||
+         ((0 == commandlineArguments.count("freq")) && (0 == commandlineArguments.count("freq_max")) && ("on-change" != PUBLISH)) ||
          (0 == commandlineArguments.count("acc_min")) ||
          (0 == commandlineArguments.count("acc_max")) ||
          (0 == commandlineArguments.count("dec_min")) ||
@@ -47,19 +214,119 @@ int32_t main(int32_t argc, char **argv) {
          (0 == commandlineArguments.count("steering_min")) ||
          (0 == commandlineArguments.count("steering_max")) ) {
         std::cerr << argv[0] << " interfaces with the given PS3 controller to emit ActuationRequest messages to an OD4Session." << std::endl;
-        std::cerr << "Usage:   " << argv[0] << " --device=<PS3 controller device> --freq=<frequency in Hz>--acc_min=<minimum acceleration> --acc_max=<maximum acceleration> --dec_min=<minimum deceleration> --dec_max=<maximum deceleration> --steering_min=<minimum steering> --steering_max=<maximum steering> --cid=<OpenDaVINCI session> [--ps4] [--verbose]" << std::endl;
+        std::cerr << "Usage:   " << argv[0] << " --device=<PS3 controller device(s) as comma separated list or glob pattern> --freq=<frequency in Hz>--acc_min=<minimum acceleration> --acc_max=<maximum acceleration> --dec_min=<minimum deceleration> --dec_max=<maximum deceleration> --steering_min=<minimum steering> --steering_max=<maximum steering> --cid=<OpenDaVINCI session> [--transport=<multicast|udp:<host>:<port>|tcp:<host>:<port>; default: multicast>] [--redundancy=<number of times to send each message via UDP; default: 1>] [--publish=<periodic|on-change>] [--max_rate=<maximum frequency in Hz for on-change sending; default: 200>] [--heartbeat=<frequency in Hz to repeat the current values for on-change sending; default: 10>] [--freq_max=<same as --freq>] [--freq_min=<frequency in Hz to send with after idling; default: 0 (always --freq)>] [--idle_time=<s without changes and with neutral values until sending with --freq_min; default: 2>] [--keepalive=<frequency in Hz to repeat unchanged values for periodic sending; default: 0 (always send)>] [--id=<sender stamp of the first controller, the following ones count up; replayed controllers keep their recorded ones; default: 0>] [--stats=<interval in s to report timing statistics; default: 0 (disabled), 1 with --probe>] [--probe (receive the sent messages to measure their latency)] [--probe_echo=<sender stamp of ActuationRequest echoes from a gateway to measure the round trip>] [--rt_priority=<SCHED_FIFO priority [1, 99] for reading and sending>] [--reader_cpu=<CPU to pin the reading thread to>] [--publisher_cpu=<CPU to pin the sending thread to>] [--mlockall] [--steering_deadzone=<fraction of the deflection around the center mapped to 0; default: 0>] [--steering_expo=<fraction [0, 1] of cubic response; default: 0>] [--steering_step=<step to round to; default: 0.25>] [--acc_deadzone=<see steering>] [--acc_expo=<see steering>] [--acc_step=<see steering>] [--steering_filter=<ema:<time constant in ms>|slew:<percent of the range per s>|median:<number of samples>>] [--acc_filter=<see steering>] [--filter_rate=<frequency in Hz to run the filters with; default: 500>] [--reconnect] [--gamepad_state] [--motion=<evdev device of the controller's motion sensors>] [--motion_batch=<number of samples per MotionSamples message; default: 32, at most 256>] [--estop_button=<number of the button to stop immediately>] [--estop_repeat=<number of emergency stop messages to send at once; default: 3>] [--record=<file to record the controller events and sent messages to>] [--replay=<file recorded before to read the controllers from instead of --device>] [--replay_speed=<factor to speed up replaying; 0 = as fast as possible; default: 1>] [--shm=<name of a shared memory area to write the latest values to for local readers>] [--ready_file=<file to create once sending; $NOTIFY_SOCKET is notified as well>] [--profile=<ps3|ps4|ps4-generic|xbox|logitech|generic|file with steering_axis = <n> and acceleration_axis = <n> lines; default: ps3>] [--ps4 (same as --profile=ps4)] [--verbose] [--verbose_rate=<maximum number of verbose records to print per second; 0 = all; default: 100>] [--verbose_sample=<print only every n-th verbose record; default: 1>]" << std::endl;
         std::cerr << "Example: " << argv[0] << " --device=/dev/input/js0 --freq=100 --acc_min=0 --acc_max=50 --dec_min=0 --dec_max=-10 --steering_min=-10 --steering_max=10 --cid=111" << std::endl;
+        std::cerr << "         " << argv[0] << " --device=/dev/input/js0 --publish=on-change --max_rate=200 --heartbeat=10 --acc_min=0 --acc_max=50 --dec_min=0 --dec_max=-10 --steering_min=-10 --steering_max=10 --cid=111" << std::endl;
+        retCode = 1;
+    }
+    else if ( ("periodic" != PUBLISH) && ("on-change" != PUBLISH) ) {
+        std::cerr << "[opendlv-device-ps3controller]: Unknown publish mode: " << PUBLISH << " (expected periodic or on-change)." << std::endl;
+        retCode = 1;
+    }
+    else if (!PROFILE.first) {
+        retCode = 1;
+    }
+    else if (!isValidCurve(commandlineArguments, "steering") | !isValidCurve(commandlineArguments, "acc")) {
+        // Both are checked to report all invalid values at once.
+        retCode = 1;
+    }
+    else if ( ("multicast" != TRANSPORT) && !IS_UNICAST ) {
+        std::cerr << "[opendlv-device-ps3controller]: Unknown transport: " << TRANSPORT << " (expected multicast, udp:<host>:<port>, or tcp:<host>:<port>)." << std::endl;
+        retCode = 1;
+    }
+    else if ( IS_UNICAST && (0 != commandlineArguments.count("probe")) && (0 == commandlineArguments.count("probe_echo")) ) {
+        // Messages sent via unicast do not loop back to the OD4Session; only a gateway's echoes could be received.
+        std::cerr << "[opendlv-device-ps3controller]: --probe cannot receive the messages sent via " << TRANSPORT << " (use --probe_echo to measure the echoes of a gateway)." << std::endl;
         retCode = 1;
     }
     else {
-        const int32_t MIN_AXES_VALUE = -32768;
-        const uint32_t MAX_AXES_VALUE = 32767;
-
+        // Verbose output is printed from a thread of its own, limited to
+        // VERBOSE_RATE records per second and sampled every VERBOSE_SAMPLE-th record.
         const bool VERBOSE{commandlineArguments.count("verbose") != 0};
-        const bool IS_PS4{commandlineArguments.count("ps4") != 0};
-        const std::string DEVICE{commandlineArguments["device"]};
+        const uint32_t VERBOSE_RATE{(commandlineArguments.count("verbose_rate") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["verbose_rate"])) : 100};
+        const uint32_t VERBOSE_SAMPLE{(commandlineArguments.count("verbose_sample") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["verbose_sample"])) : 1};
+        const uint8_t STEERING_AXIS{PROFILE.second.steeringAxis};
+        const uint8_t ACCELERATION_AXIS{PROFILE.second.accelerationAxis};
+        std::clog << "[opendlv-device-ps3controller]: Using controller profile " << PROFILE.second.name << ", steering axis: " << +STEERING_AXIS << ", acceleration axis: " << +ACCELERATION_AXIS << std::endl;
+        const std::string DEVICE{(commandlineArguments.count("device") != 0) ? commandlineArguments["device"] : ""};
+        const uint32_t ID{(commandlineArguments.count("id") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["id"])) : 0};
+
+        // In on-change mode, values are sent as soon as they change (limited
+        // to MAX_RATE) and repeated with HEARTBEAT as keepalive otherwise.
+        const bool PUBLISH_ON_CHANGE{"on-change" == PUBLISH};
+        const float MAX_RATE{(commandlineArguments.count("max_rate") != 0) ? std::stof(commandlineArguments["max_rate"]) : 200.0f};
+        const float HEARTBEAT{(commandlineArguments.count("heartbeat") != 0) ? std::stof(commandlineArguments["heartbeat"]) : 10.0f};
+        const int64_t MIN_SEND_INTERVAL_IN_MICROSECONDS{static_cast<int64_t>(1000.0f * 1000.0f / ((MAX_RATE > 0) ? MAX_RATE : 1.0f))};
+
+        // In probe mode, the sent ActuationRequest messages are received
+        // again (and echoes of them from a cooperating gateway with sender
+        // stamp PROBE_ECHO) to measure their latency with the statistics.
+        const bool PROBE{commandlineArguments.count("probe") != 0};
+        const int64_t PROBE_ECHO{(commandlineArguments.count("probe_echo") != 0) ? std::stoll(commandlineArguments["probe_echo"]) : -1};
 
-        const float FREQ = std::stof(commandlineArguments["freq"]);
+        // Timing statistics are reported every STATS seconds if enabled.
+        const float STATS{(commandlineArguments.count("stats") != 0) ? std::stof(commandlineArguments["stats"]) : (PROBE ? 1.0f : 0.0f)};
+        const bool HAS_STATISTICS{STATS > 0};
+
+        // Optional real-time scheduling for the reading and the sending thread.
+        const int32_t RT_PRIORITY{(commandlineArguments.count("rt_priority") != 0) ? std::stoi(commandlineArguments["rt_priority"]) : 0};
+        const int32_t READER_CPU{(commandlineArguments.count("reader_cpu") != 0) ? std::stoi(commandlineArguments["reader_cpu"]) : -1};
+        const int32_t PUBLISHER_CPU{(commandlineArguments.count("publisher_cpu") != 0) ? std::stoi(commandlineArguments["publisher_cpu"]) : -1};
+        const bool MLOCKALL{commandlineArguments.count("mlockall") != 0};
+
+        // In reconnect mode, disconnected controllers are reopened as soon as
+        // their devices reappear instead of stopping the microservice.
+        // Controller events and all sent messages can be recorded to a .rec
+        // file; replaying such a file reproduces the recorded controllers.
+        const std::string RECORD{(commandlineArguments.count("record") != 0) ? commandlineArguments["record"] : ""};
+        const std::string REPLAY{(commandlineArguments.count("replay") != 0) ? commandlineArguments["replay"] : ""};
+        const bool IS_REPLAY{!REPLAY.empty()};
+        const double REPLAY_SPEED{(commandlineArguments.count("replay_speed") != 0) ? std::stod(commandlineArguments["replay_speed"]) : 1.0};
+
+        // Optionally, the latest values are also written to a shared memory
+        // area that local readers can access without any system call.
+        const std::string SHM{(commandlineArguments.count("shm") != 0) ? commandlineArguments["shm"] : ""};
+
+        // The motion sensors of a controller, exposed as evdev device of
+        // their own, are sent in batches of MOTION_BATCH samples.
+        const std::string MOTION{(commandlineArguments.count("motion") != 0) ? commandlineArguments["motion"] : ""};
+        const uint32_t MAX_MOTION_BATCH{256};
+        const uint32_t MOTION_BATCH{std::max<uint32_t>(1, std::min<uint32_t>(MAX_MOTION_BATCH, (commandlineArguments.count("motion_batch") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["motion_batch"])) : 32))};
+
+        // Supervisors are notified once the values are sent periodically.
+        const std::string READY_FILE{(commandlineArguments.count("ready_file") != 0) ? commandlineArguments["ready_file"] : ""};
+
+        const bool RECONNECT{(commandlineArguments.count("reconnect") != 0) && !IS_REPLAY};
+
+        // Optionally, the raw values of all axes and buttons are sent as
+        // GamepadState along with each ActuationRequest.
+        const bool PUBLISH_GAMEPAD_STATE{commandlineArguments.count("gamepad_state") != 0};
+
+        // Pressing the emergency stop button sends ESTOP_REPEAT messages with
+        // full deceleration and isValid = false right away from the reading
+        // thread; further messages carry these values until the button is
+        // released and the acceleration axis is back at zero.
+        const int32_t ESTOP_BUTTON{(commandlineArguments.count("estop_button") != 0) ? std::stoi(commandlineArguments["estop_button"]) : -1};
+        const bool HAS_ESTOP{(-1 < ESTOP_BUTTON) && (static_cast<std::size_t>(ESTOP_BUTTON) < InputEvents::MAX_NUMBER_OF_BUTTONS)};
+        const uint32_t ESTOP_REPEAT{(commandlineArguments.count("estop_repeat") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["estop_repeat"])) : 3};
+
+        const float FREQ = (PUBLISH_ON_CHANGE ? HEARTBEAT : std::stof(commandlineArguments[(commandlineArguments.count("freq_max") != 0) ? "freq_max" : "freq"]));
+
+        // With a minimum frequency in periodic mode, the values are sent with
+        // FREQ while they change or are away from neutral and with FREQ_MIN
+        // once they were idle for IDLE_TIME seconds.
+        const float FREQ_MIN{(commandlineArguments.count("freq_min") != 0) ? std::stof(commandlineArguments["freq_min"]) : 0.0f};
+        const bool ADAPTIVE{!PUBLISH_ON_CHANGE && (FREQ_MIN > 0) && (FREQ_MIN < FREQ)};
+        const float IDLE_TIME{(commandlineArguments.count("idle_time") != 0) ? std::stof(commandlineArguments["idle_time"]) : 2.0f};
+
+        // With a keepalive in periodic mode, unchanged values are only sent
+        // every KEEPALIVE_TICKS periods instead of every period.
+        const float KEEPALIVE{(commandlineArguments.count("keepalive") != 0) ? std::stof(commandlineArguments["keepalive"]) : 0.0f};
+        const bool SUPPRESS_UNCHANGED{!PUBLISH_ON_CHANGE && !ADAPTIVE && (KEEPALIVE > 0) && (KEEPALIVE < FREQ)};
+        if (ADAPTIVE && (KEEPALIVE > 0)) {
+            std::cerr << "[opendlv-device-ps3controller]: --keepalive is ignored with --freq_min." << std::endl;
+        }
+        const uint32_t KEEPALIVE_TICKS{SUPPRESS_UNCHANGED ? static_cast<uint32_t>(std::ceil(FREQ / KEEPALIVE)) : 1};
         const float ACCELERATION_MIN = std::stof(commandlineArguments["acc_min"]);
         const float ACCELERATION_MAX = std::stof(commandlineArguments["acc_max"]);
         const float DECELERATION_MIN = std::stof(commandlineArguments["dec_min"]);
@@ -67,172 +334,996 @@ int32_t main(int32_t argc, char **argv) {
         const float STEERING_MIN = std::stof(commandlineArguments["steering_min"]);
         const float STEERING_MAX = std::stof(commandlineArguments["steering_max"]);
 
-        int ps3controllerDevice;
-        if ( -1 == (ps3controllerDevice = ::open(DEVICE.c_str(), O_RDONLY)) ) {
-            std::cerr << "[opendlv-device-ps3controller]: Could not open device: " << DEVICE << ", error: " << errno << ": " << strerror(errno) << std::endl;
+        // Response curves of the axes.
+        auto curveOf = [&commandlineArguments](const std::string &prefix) {
+            AxisMapping::Curve curve;
+            curve.deadzone = (commandlineArguments.count(prefix + "_deadzone") != 0) ? std::stof(commandlineArguments[prefix + "_deadzone"]) : curve.deadzone;
+            curve.expo = (commandlineArguments.count(prefix + "_expo") != 0) ? std::stof(commandlineArguments[prefix + "_expo"]) : curve.expo;
+            curve.step = (commandlineArguments.count(prefix + "_step") != 0) ? std::stof(commandlineArguments[prefix + "_step"]) : curve.step;
+            return curve;
+        };
+
+        // Optional filters for the raw values of both axes.
+        const std::string STEERING_FILTER{(commandlineArguments.count("steering_filter") != 0) ? commandlineArguments["steering_filter"] : ""};
+        const std::string ACCELERATION_FILTER{(commandlineArguments.count("acc_filter") != 0) ? commandlineArguments["acc_filter"] : ""};
+        const bool HAS_FILTER{!STEERING_FILTER.empty() || !ACCELERATION_FILTER.empty()};
+        const float FILTER_RATE{(commandlineArguments.count("filter_rate") != 0) ? std::stof(commandlineArguments["filter_rate"]) : 500.0f};
+
+        const int64_t ARGUMENTS_PARSED_IN_MICROSECONDS{elapsedInMicroseconds()};
+
+        // Replayed controllers are ordered by and sent with their recorded
+        // sender stamps; other controllers count up from ID.
+        std::map<uint32_t, std::vector<ReplayDevice::Event>> recording;
+        std::vector<std::string> devices;
+        std::vector<uint32_t> senderStamps;
+        if (IS_REPLAY) {
+            recording = loadRecording(REPLAY);
+            for (const auto &events : recording) {
+                devices.push_back(REPLAY + ":" + std::to_string(events.first));
+                senderStamps.push_back(events.first);
+            }
+            if (recording.empty()) {
+                std::cerr << "[opendlv-device-ps3controller]: No controller events found in " << REPLAY << "." << std::endl;
+            }
         }
         else {
-            int num_of_axes{0};
-            int num_of_buttons{0};
-            char name_of_ps3controller[80];
-
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Woverflow"
-            ::ioctl(ps3controllerDevice, JSIOCGAXES, &num_of_axes);
-            ::ioctl(ps3controllerDevice, JSIOCGBUTTONS, &num_of_buttons);
-#pragma GCC diagnostic pop
-            if (::ioctl(ps3controllerDevice, JSIOCGNAME(80), &name_of_ps3controller) < 0) {
-                ::strncpy(name_of_ps3controller, "Unknown", sizeof(name_of_ps3controller));
-            }
-            std::clog << "[opendlv-device-ps3controller]: Found " << std::string(name_of_ps3controller) << ", number of axes: " << num_of_axes << ", number of buttons: " << num_of_buttons << std::endl;
-
-            // Use non blocking reading.
-            fcntl(ps3controllerDevice, F_SETFL, O_NONBLOCK);
-
-            std::mutex valuesMutex;
-            float acceleration{0};
-            float steering{0};
-            bool hasError{false};
-
-            // Thread to read values.
-            std::thread ps3controllerReadingThread([&IS_PS4,
-                                                    &MIN_AXES_VALUE,
-                                                    &MAX_AXES_VALUE,
-                                                    VERBOSE,
-                                                    &ACCELERATION_MIN,
-                                                    &ACCELERATION_MAX,
-                                                    &DECELERATION_MIN,
-                                                    &DECELERATION_MAX,
-                                                    &STEERING_MIN,
-                                                    &STEERING_MAX,
-                                                    &valuesMutex,
-                                                    &acceleration,
-                                                    &steering,
+            devices = listDevices(DEVICE);
+            for (std::size_t i{0}; i < devices.size(); i++) {
+                senderStamps.push_back(ID + static_cast<uint32_t>(i));
+            }
+        }
+        auto recorded = recording.begin();
+
+        // This microservice only sends: Instead of an OD4Session, whose
+        // receiving thread would join the multicast group and copy every
+        // datagram of the CID, all messages are encoded into preallocated
+        // buffers and sent directly to the OD4Session's multicast group or
+        // to the gateway given with --transport; the messages of one period
+        // are sent with one system call. OD4Session would also stop on
+        // SIGINT and SIGTERM.
+        cluon::TerminateHandler::instance();
+        const uint16_t CID{static_cast<uint16_t>(std::stoi(commandlineArguments["cid"]))};
+        const std::string SEND_TO_ADDRESS{IS_UNICAST ? TRANSPORT.substr(4, PORT_SEPARATOR - 4) : "225.0.0." + std::to_string(CID)};
+        const uint16_t SEND_TO_PORT{IS_UNICAST ? static_cast<uint16_t>(std::stoi(TRANSPORT.substr(PORT_SEPARATOR + 1))) : static_cast<uint16_t>(12175)};
+        const bool IS_TCP{0 == TRANSPORT.find("tcp:")};
+        const uint32_t REDUNDANCY{(commandlineArguments.count("redundancy") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["redundancy"])) : 1};
+        BatchSender batchSender{SEND_TO_ADDRESS, SEND_TO_PORT, (IS_TCP ? BatchSender::Protocol::TCP : BatchSender::Protocol::UDP), REDUNDANCY};
+        if (IS_UNICAST) {
+            std::clog << "[opendlv-device-ps3controller]: Sending to " << SEND_TO_ADDRESS << ":" << SEND_TO_PORT << " via " << (IS_TCP ? "TCP" : "UDP")
+                      << ((!IS_TCP && (1 < REDUNDANCY)) ? ", each message " + std::to_string(REDUNDANCY) + " times" : std::string{}) << "." << std::endl;
+        }
+        EnvelopeEncoder<opendlv::proxy::ActuationRequest> arEncoder;
+        EnvelopeEncoder<opendlv::proxy::GamepadState, 2 * InputEvents::MAX_NUMBER_OF_AXES + 64> gamepadStateEncoder;
+
+        // All sent envelopes pass here to be recorded if enabled.
+        std::unique_ptr<Recorder> recorder{RECORD.empty() ? nullptr : new Recorder(RECORD)};
+        auto send = [&batchSender, &recorder](std::string &envelope) {
+            if (recorder) {
+                recorder->write(envelope);
+            }
+            batchSender.send(envelope);
+        };
+        auto queue = [&batchSender, &recorder](std::string &envelope) {
+            if (recorder) {
+                recorder->write(envelope);
+            }
+            batchSender.queue(envelope);
+        };
+
+        // Receivers see a safe stop for every controller before it is opened.
+        opendlv::proxy::ActuationRequest safeStop;
+        safeStop.acceleration(0).steering(0).isValid(false);
+        for (const uint32_t senderStamp : senderStamps) {
+            queue(arEncoder.encode(safeStop, cluon::data::TimeStamp(), senderStamp));
+        }
+        batchSender.flush();
+        const int64_t SAFE_STOP_SENT_IN_MICROSECONDS{elapsedInMicroseconds()};
+
+        // Values of all axis positions are computed at start.
+        const AxisMapping steeringMapping{[&STEERING_MIN, &STEERING_MAX](float percent) {
+                                              // map the steering from percentage to its range
+                                              return -1.0f * (percent/100.0f*(STEERING_MAX-STEERING_MIN)+STEERING_MIN);
+                                          }, curveOf("steering")};
+        const AxisMapping accelerationMapping{[&ACCELERATION_MIN, &ACCELERATION_MAX, &DECELERATION_MIN, &DECELERATION_MAX](float percent) {
+                                                  // map the acceleration from percentage to its range; the upper half of the axis (percent > 50) is braking
+                                                  return (percent < 50.0f) ? (100.0f-2.0f*percent)/100.0f*(ACCELERATION_MAX-ACCELERATION_MIN)+ACCELERATION_MIN
+                                                                           : (2.0f*percent-100.0f)/100.0f*(DECELERATION_MAX-DECELERATION_MIN);
+                                              }, curveOf("acc")};
+
+        // Each controller is read from its own device and sent with its own sender stamp.
+        std::vector<std::unique_ptr<Controller>> controllers;
+        for (const std::string &device : devices) {
+            std::unique_ptr<Controller> controller{new Controller()};
+            controller->device = device;
+            controller->senderStamp = senderStamps[controllers.size()];
+            if (HAS_FILTER) {
+                controller->filter.reset(new AxisFilter(FILTER_RATE));
+                if ( (!STEERING_FILTER.empty() && !controller->filter->configure(STEERING_AXIS, STEERING_FILTER)) ||
+                     (!ACCELERATION_FILTER.empty() && !controller->filter->configure(ACCELERATION_AXIS, ACCELERATION_FILTER)) ) {
+                    std::cerr << "[opendlv-device-ps3controller]: Invalid filter: " << STEERING_FILTER << " " << ACCELERATION_FILTER << std::endl;
+                    controllers.clear();
+                    break;
+                }
+            }
+            if (IS_REPLAY) {
+                controller->inputDevice.reset(new ReplayDevice("Replay of sender stamp " + std::to_string(recorded->first), std::move(recorded->second), REPLAY_SPEED));
+                recorded++;
+            }
+            else {
+                controller->inputDevice = openInputDevice(device);
+            }
+            if (controller->inputDevice) {
+                std::clog << "[opendlv-device-ps3controller]: Found " << controller->inputDevice->name() << " at " << device << ", number of axes: " << controller->inputDevice->numberOfAxes() << ", number of buttons: " << controller->inputDevice->numberOfButtons() << ", sender stamp: " << controller->senderStamp << std::endl;
+            }
+            else if (RECONNECT) {
+                std::clog << "[opendlv-device-ps3controller]: Waiting for " << device << ", sender stamp: " << controller->senderStamp << std::endl;
+                store(*controller, ControllerState{0, 0, 0, false});
+            }
+            else {
+                controllers.clear();
+                break;
+            }
+            controllers.push_back(std::move(controller));
+        }
+        const int64_t DEVICES_OPENED_IN_MICROSECONDS{elapsedInMicroseconds()};
+        if (!controllers.empty()) {
+            std::atomic<bool> hasError{false};
+            // Set once all replayed controllers are finished.
+            std::atomic<bool> isReplayFinished{false};
+
+            std::unique_ptr<cluon::SharedMemory> sharedMemory{nullptr};
+            if (!SHM.empty()) {
+                sharedMemory.reset(new cluon::SharedMemory{SHM, SharedControllerStates::size()});
+                if (sharedMemory->valid()) {
+                    SharedControllerStates *states{new (SharedControllerStates::at(sharedMemory->data())) SharedControllerStates()};
+                    for (const auto &controller : controllers) {
+                        if (states->numberOfControllers < SharedControllerStates::MAX_NUMBER_OF_CONTROLLERS) {
+                            controller->sharedMemory = sharedMemory.get();
+                            controller->sharedState = &states->controllers[states->numberOfControllers++];
+                            store(*controller, controller->state.load());
+                        }
+                        else {
+                            std::cerr << "[opendlv-device-ps3controller]: Sender stamp " << controller->senderStamp << " does not fit into " << sharedMemory->name() << "." << std::endl;
+                        }
+                    }
+                    states->magic.store(SharedControllerStates::MAGIC, std::memory_order_release);
+                    std::clog << "[opendlv-device-ps3controller]: Writing the latest values to " << sharedMemory->name() << " (" << sharedMemory->size() << " bytes)." << std::endl;
+                }
+                else {
+                    std::cerr << "[opendlv-device-ps3controller]: Could not create shared memory " << SHM << "." << std::endl;
+                }
+            }
+
+            std::unique_ptr<VerboseLog> verboseLog{VERBOSE ? new VerboseLog(VERBOSE_RATE, VERBOSE_SAMPLE) : nullptr};
+
+            // Signalled to wake up and stop the reading thread.
+            int wakeupEvent{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+
+            // Timing statistics recorded on the hot paths.
+            LatencyHistogram inputToSendLatency;
+            LatencyHistogram tickJitter;
+            LatencyHistogram eventsPerWakeup;
+            LatencyHistogram handoffDuration;
+            LatencyHistogram emergencyStopLatency;
+
+            // The probe receives from the OD4Session in a thread of its own.
+            // The sender stamps ascend but may have gaps when replaying.
+            const uint32_t FIRST_SENDER_STAMP{controllers.front()->senderStamp};
+            const uint32_t NUMBER_OF_SENDER_STAMPS{controllers.back()->senderStamp - FIRST_SENDER_STAMP + 1};
+            std::unique_ptr<LatencyProbe> probe{PROBE ? new LatencyProbe(FIRST_SENDER_STAMP, NUMBER_OF_SENDER_STAMPS, PROBE_ECHO) : nullptr};
+            std::unique_ptr<cluon::OD4Session> probeSession{PROBE ? new cluon::OD4Session(CID) : nullptr};
+            if (probeSession) {
+                probeSession->dataTrigger(opendlv::proxy::ActuationRequest::ID(), [&probe](cluon::data::Envelope &&envelope) {
+                    probe->received(envelope.senderStamp(), cluon::time::toMicroseconds(envelope.sampleTimeStamp()),
+                                    cluon::time::toMicroseconds(envelope.sent()), cluon::time::toMicroseconds(envelope.received()));
+                });
+                std::clog << "[opendlv-device-ps3controller]: Probing the latency of the sent messages"
+                          << (probe->hasEcho() ? " and their echoes with sender stamp " + std::to_string(PROBE_ECHO) : std::string{}) << "." << std::endl;
+            }
+
+            // Periodic sending; the reading thread speeds it up on activity.
+            PeriodicScheduler publisher{FREQ, (ADAPTIVE ? FREQ_MIN : 0.0f)};
+            if (PUBLISH_ON_CHANGE || SUPPRESS_UNCHANGED) {
+                // Receivers rely on this interval to detect a stale controller.
+                std::clog << "[opendlv-device-ps3controller]: Unchanged values are repeated at least every "
+                          << (KEEPALIVE_TICKS * publisher.periodInNanoseconds() / (1000 * 1000)) << " ms." << std::endl;
+            }
+            else if (ADAPTIVE) {
+                std::clog << "[opendlv-device-ps3controller]: Values are sent every " << (publisher.periodInNanoseconds() / (1000 * 1000))
+                          << " ms while active and at least every " << (publisher.slowPeriodInNanoseconds() / (1000 * 1000)) << " ms after "
+                          << IDLE_TIME << " s of idling." << std::endl;
+            }
+
+            // Thread to read values of all controllers.
+            std::thread ps3controllerReadingThread([&STEERING_AXIS,
+                                                    &ACCELERATION_AXIS,
+                                                    &verboseLog,
+                                                    &steeringMapping,
+                                                    &accelerationMapping,
+                                                    &controllers,
                                                     &hasError,
-                                                    &ps3controllerDevice]() {
-                struct timeval timeout {};
-                fd_set setOfFiledescriptorsToReadFrom{};
-
-                while (!hasError) {
-                    // Define timeout for select system call. The timeval struct must be
-                    // reinitialized for every select call as it might be modified containing
-                    // the actual time slept.
-                    timeout.tv_sec  = 0;
-                    timeout.tv_usec = 20 * 1000; // Check for new data with 50Hz.
-
-                    FD_ZERO(&setOfFiledescriptorsToReadFrom);
-                    FD_SET(ps3controllerDevice, &setOfFiledescriptorsToReadFrom);
-                    ::select(ps3controllerDevice + 1, &setOfFiledescriptorsToReadFrom, nullptr, nullptr, &timeout);
-
-                    if (FD_ISSET(ps3controllerDevice, &setOfFiledescriptorsToReadFrom)) {
-                        std::lock_guard<std::mutex> lck(valuesMutex);
-
-                        struct js_event js;
-                        while (::read(ps3controllerDevice, &js, sizeof(struct js_event)) > 0) {
-                            float percent{0};
-                            switch (js.type & ~JS_EVENT_INIT) {
-                                case JS_EVENT_AXIS:
-                                {
-                                    if (0 == js.number) { // LEFT ANALOG STICK
-                                        // this will return a percent value over the whole range
-                                        percent = static_cast<float>(js.value - MIN_AXES_VALUE)/static_cast<float>(MAX_AXES_VALUE-MIN_AXES_VALUE)*100.0f;
-
-                                        if (VERBOSE) {
-                                            if (percent > 49.95f && percent < 50.05f) {
-                                                std::cout << "[opendlv-device-ps3controller]: Going straight." << std::endl;
-                                            }
-                                            else {
-                                                // this will return values in the range [0-100] for both a left or right turn (instead of [0-50] for left and [50-100] for right)
-                                                std::cout << "[opendlv-device-ps3controller]: Turning "<< (js.value<0?"left":"right") << " at " << (js.value<0?(100.0f-2.0f*percent):(2.0f*percent-100.0f)) <<"%." << std::endl;
-                                            }
-                                        }
+                                                    &PUBLISH_ON_CHANGE,
+                                                    &MIN_SEND_INTERVAL_IN_MICROSECONDS,
+                                                    &send,
+                                                    &wakeupEvent,
+                                                    HAS_STATISTICS,
+                                                    &inputToSendLatency,
+                                                    &eventsPerWakeup,
+                                                    RT_PRIORITY,
+                                                    READER_CPU,
+                                                    RECONNECT,
+                                                    PUBLISH_GAMEPAD_STATE,
+                                                    HAS_ESTOP,
+                                                    ESTOP_BUTTON,
+                                                    ESTOP_REPEAT,
+                                                    &DECELERATION_MAX,
+                                                    &emergencyStopLatency,
+                                                    &probe,
+                                                    HAS_FILTER,
+                                                    FILTER_RATE,
+                                                    &recorder,
+                                                    IS_REPLAY,
+                                                    ADAPTIVE,
+                                                    &publisher,
+                                                    &isReplayFinished]() {
+                if (0 < RT_PRIORITY) {
+                    setRealtimePriority(RT_PRIORITY);
+                }
+                if (-1 < READER_CPU) {
+                    setCpuAffinity(READER_CPU);
+                }
 
-                                        // map the steering from percentage to its range
-                                        steering = percent/100.0f*(STEERING_MAX-STEERING_MIN)+STEERING_MIN;
-                                        steering *= -1.0f;
-                                        // modify in steps of 0.25
-                                        steering = ::roundf(4.0f*steering)/4.0f;
-                                        
-                                        // Clamp value to avoid showing "-0" (just "0" looks better imo)
-                                        if (steering < 0.001f && steering >-0.001f) {
-                                            steering = 0;
-                                        }
-                                    }
-                                    // no else-if as many of these events can occur simultaneously
-                                    if (((!IS_PS4) ? (4 == js.number) : (5 == js.number))) { // RIGHT ANALOG STICK
-                                        // this will return a percent value over the whole range
-                                        percent = static_cast<float>(js.value-MIN_AXES_VALUE)/static_cast<float>(MAX_AXES_VALUE-MIN_AXES_VALUE)*100.0f;
-                                        // this will return values in the range [0-100] for both accelerating and braking (instead of [50-0] for accelerating and [50-100] for braking)
-                                        if (VERBOSE) {
-                                            std::cout << "[opendlv-device-ps3controller]: " << (js.value<0?"Accelerating":"Braking") <<" at "<< (js.value<0?(100.0f-2.0f*percent):(2.0f*percent-100.0f)) << "%." << std::endl;
-                                        }
+                // The thread sleeps until a device has new events, a
+                // deferred on-change message is due, a device node was
+                // created or changed, or it is woken up to stop.
+                int sendTimer{::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)};
+                int epollDescriptor{::epoll_create1(EPOLL_CLOEXEC)};
+                int deviceWatch{RECONNECT ? ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC) : -1};
+                int filterTimer{HAS_FILTER ? ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC) : -1};
+                if ( (-1 == sendTimer) || (-1 == epollDescriptor) || (RECONNECT && (-1 == deviceWatch)) || (HAS_FILTER && (-1 == filterTimer)) ) {
+                    std::cerr << "[opendlv-device-ps3controller]: Could not create epoll/timerfd/inotify: " << errno << ": " << strerror(errno) << std::endl;
+                    hasError = true;
+                }
+                auto watch = [&epollDescriptor, &hasError](int fd) {
+                    struct epoll_event ev{};
+                    ev.events = EPOLLIN;
+                    ev.data.fd = fd;
+                    if (!hasError && (0 != ::epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, fd, &ev))) {
+                        std::cerr << "[opendlv-device-ps3controller]: Could not watch file descriptor: " << errno << ": " << strerror(errno) << std::endl;
+                        hasError = true;
+                    }
+                };
+                watch(wakeupEvent);
+                watch(sendTimer);
+                if (RECONNECT) {
+                    watch(deviceWatch);
+                }
+                if (HAS_FILTER) {
+                    watch(filterTimer);
+                }
+                for (const auto &controller : controllers) {
+                    if (controller->inputDevice) {
+                        watch(controller->inputDevice->fileDescriptor());
+                    }
+                    if (RECONNECT && !hasError) {
+                        // Device nodes are created in and removed from their directories.
+                        const std::string &DEVICE_PATH{controller->device};
+                        const std::size_t SLASH{DEVICE_PATH.rfind('/')};
+                        const std::string DIRECTORY{(std::string::npos == SLASH) ? "." : ((0 == SLASH) ? "/" : DEVICE_PATH.substr(0, SLASH))};
+                        if (0 > ::inotify_add_watch(deviceWatch, DIRECTORY.c_str(), IN_CREATE | IN_ATTRIB | IN_MOVED_TO)) {
+                            std::cerr << "[opendlv-device-ps3controller]: Could not watch " << DIRECTORY << ": " << errno << ": " << strerror(errno) << std::endl;
+                            hasError = true;
+                        }
+                    }
+                }
 
-                                        if (js.value < 0) {
-                                            // map the acceleration from percentage to its range
-                                            acceleration=(100.0f-2.0f*percent)/100.0f*(ACCELERATION_MAX-ACCELERATION_MIN)+ACCELERATION_MIN;
-                                        }
-                                        else {
-                                            // map the acceleration from percentage to its range
-                                            acceleration = (2.0f*percent-100.0f)/100.0f*(DECELERATION_MAX-DECELERATION_MIN);
-                                        }
+                // Encodes the ActuationRequests sent from this thread in on-change mode.
+                EnvelopeEncoder<opendlv::proxy::ActuationRequest> changedArEncoder;
+
+                // Records the raw values read from a controller before filtering.
+                EnvelopeEncoder<opendlv::proxy::ControllerEvent> controllerEventEncoder;
+                opendlv::proxy::ControllerEvent controllerEvent;
+                auto record = [&recorder, &controllerEventEncoder, &controllerEvent](const Controller &c) {
+                    for (uint32_t axis{0}; c.inputEvents.updatedAxes.any() && (axis < InputEvents::MAX_NUMBER_OF_AXES); axis++) {
+                        if (c.inputEvents.updatedAxes.test(axis)) {
+                            controllerEvent.type(ReplayDevice::AXIS).number(static_cast<uint16_t>(axis)).value(c.inputEvents.axisValues[axis]);
+                            recorder->write(controllerEventEncoder.encode(controllerEvent, cluon::time::fromMicroseconds(c.inputEvents.axisSampleTimesInMicroseconds[axis]), c.senderStamp));
+                        }
+                    }
+                    for (uint32_t button{0}; c.inputEvents.updatedButtons.any() && (button < InputEvents::MAX_NUMBER_OF_BUTTONS); button++) {
+                        if (c.inputEvents.updatedButtons.test(button)) {
+                            controllerEvent.type(ReplayDevice::BUTTON).number(static_cast<uint16_t>(button)).value(c.inputEvents.buttons.test(button) ? 1 : 0);
+                            recorder->write(controllerEventEncoder.encode(controllerEvent, cluon::time::fromMicroseconds(c.inputEvents.buttonSampleTimesInMicroseconds[button]), c.senderStamp));
+                        }
+                    }
+                };
+                bool isRunning{true};
+
+                // Replaces a controller's values by a safe stop until its device reappears.
+                auto disconnect = [&changedArEncoder, &send](Controller &c) {
+                    std::cerr << "[opendlv-device-ps3controller]: Waiting for " << c.device << " to reconnect." << std::endl;
+                    c.inputDevice.reset();
+                    c.inputEvents = InputEvents{};
+                    if (c.filter) {
+                        c.filter->reset();
+                    }
+                    c.acceleration = c.steering = 0;
+                    c.accelerationSampleTimeInMicroseconds = c.steeringSampleTimeInMicroseconds = c.sampleTimeInMicroseconds = 0;
+                    store(c, ControllerState{0, 0, 0, false});
+                    c.inputs.store(ControllerInputs{});
+
+                    c.changedAr.acceleration(0).steering(0).isValid(false);
+                    send(changedArEncoder.encode(c.changedAr, cluon::data::TimeStamp(), c.senderStamp));
+                    c.lastChangeSentInMicroseconds = cluon::time::toMicroseconds(cluon::time::now());
+                };
+
+                // The filters only run until their outputs settled.
+                bool isFilterTimerArmed{false};
+                auto armFilterTimer = [&filterTimer, &isFilterTimerArmed, &FILTER_RATE]() {
+                    if (!isFilterTimerArmed) {
+                        const int64_t PERIOD_IN_NANOSECONDS{static_cast<int64_t>(1000.0 * 1000.0 * 1000.0 / static_cast<double>(FILTER_RATE))};
+                        struct itimerspec period{};
+                        period.it_interval.tv_sec = period.it_value.tv_sec = PERIOD_IN_NANOSECONDS / (1000 * 1000 * 1000);
+                        period.it_interval.tv_nsec = period.it_value.tv_nsec = PERIOD_IN_NANOSECONDS % (1000 * 1000 * 1000);
+                        ::timerfd_settime(filterTimer, 0, &period, nullptr);
+                        isFilterTimerArmed = true;
+                    }
+                };
 
-                                        // modify in steps of 0.25
-                                        acceleration = ::roundf(4.0f*acceleration)/4.0f;
+                // Maps the controller's updated values and hands them over.
+                auto process = [&STEERING_AXIS,
+                                &ACCELERATION_AXIS,
+                                &verboseLog,
+                                &steeringMapping,
+                                &accelerationMapping,
+                                PUBLISH_GAMEPAD_STATE,
+                                HAS_ESTOP,
+                                ESTOP_BUTTON,
+                                ESTOP_REPEAT,
+                                &DECELERATION_MAX,
+                                &changedArEncoder,
+                                &send,
+                                HAS_STATISTICS,
+                                ADAPTIVE,
+                                &publisher,
+                                &emergencyStopLatency,
+                                &probe](Controller &c) {
+                    const std::array<int16_t, InputEvents::MAX_NUMBER_OF_AXES> &axisValues = c.inputEvents.axisValues;
+                    const std::bitset<InputEvents::MAX_NUMBER_OF_AXES> &updatedAxes = c.inputEvents.updatedAxes;
 
-                                        // Clamp value to avoid showing "-0" (just "0" looks better imo)
-                                        if (acceleration < 0.001f && acceleration >-0.001f) {
-                                            acceleration = 0;
+                    const float PREVIOUS_STEERING{c.steering};
+                    const float PREVIOUS_ACCELERATION{c.acceleration};
+
+                    if (updatedAxes.test(STEERING_AXIS)) { // LEFT ANALOG STICK
+                        const int16_t value{axisValues[STEERING_AXIS]};
+                        if (verboseLog) {
+                            VerboseLog::Record entry;
+                            entry.kind = VerboseLog::Record::STEERING;
+                            entry.timeInMicroseconds = c.inputEvents.axisSampleTimesInMicroseconds[STEERING_AXIS];
+                            entry.value = value;
+                            verboseLog->fromReadingThread(entry);
+                        }
+                        c.steering = steeringMapping.map(value);
+                    }
+                    // no else-if as both axes can change simultaneously
+                    if (updatedAxes.test(ACCELERATION_AXIS)) { // RIGHT ANALOG STICK
+                        const int16_t value{axisValues[ACCELERATION_AXIS]};
+                        if (verboseLog) {
+                            VerboseLog::Record entry;
+                            entry.kind = VerboseLog::Record::ACCELERATION;
+                            entry.timeInMicroseconds = c.inputEvents.axisSampleTimesInMicroseconds[ACCELERATION_AXIS];
+                            entry.value = value;
+                            verboseLog->fromReadingThread(entry);
+                        }
+                        c.acceleration = accelerationMapping.map(value);
+                    }
+
+                    // Keep the capture time of the events that actually changed the values.
+                    if (std::fabs(c.steering - PREVIOUS_STEERING) > 0.001f) {
+                        c.steeringSampleTimeInMicroseconds = c.inputEvents.axisSampleTimesInMicroseconds[STEERING_AXIS];
+                    }
+                    if (std::fabs(c.acceleration - PREVIOUS_ACCELERATION) > 0.001f) {
+                        c.accelerationSampleTimeInMicroseconds = c.inputEvents.axisSampleTimesInMicroseconds[ACCELERATION_AXIS];
+                    }
+                    c.sampleTimeInMicroseconds = std::max(c.steeringSampleTimeInMicroseconds, c.accelerationSampleTimeInMicroseconds);
+
+                    if (PUBLISH_GAMEPAD_STATE) {
+                        ControllerInputs inputs{c.inputs.load()};
+                        inputs.numberOfAxes = static_cast<uint16_t>(std::min<uint32_t>(c.inputDevice->numberOfAxes(), InputEvents::MAX_NUMBER_OF_AXES));
+                        inputs.numberOfButtons = static_cast<uint16_t>(std::min<uint32_t>(c.inputDevice->numberOfButtons(), InputEvents::MAX_NUMBER_OF_BUTTONS));
+                        std::copy(axisValues.begin(), axisValues.begin() + inputs.numberOfAxes, inputs.axes.begin());
+                        inputs.buttons = (c.inputEvents.buttons & std::bitset<InputEvents::MAX_NUMBER_OF_BUTTONS>{UINT64_MAX}).to_ullong();
+                        for (uint32_t axis{0}; axis < inputs.numberOfAxes; axis++) {
+                            if (updatedAxes.test(axis)) {
+                                inputs.sampleTimeInMicroseconds = std::max(inputs.sampleTimeInMicroseconds, c.inputEvents.axisSampleTimesInMicroseconds[axis]);
+                            }
+                        }
+                        for (uint32_t button{0}; button < inputs.numberOfButtons; button++) {
+                            if (c.inputEvents.updatedButtons.test(button)) {
+                                inputs.sampleTimeInMicroseconds = std::max(inputs.sampleTimeInMicroseconds, c.inputEvents.buttonSampleTimesInMicroseconds[button]);
+                            }
+                        }
+                        c.inputs.store(inputs);
+                    }
+
+                    if (HAS_ESTOP) {
+                        const std::size_t BUTTON{static_cast<std::size_t>(ESTOP_BUTTON)};
+                        const bool IS_PRESSED{c.inputEvents.buttons.test(BUTTON)};
+                        if (IS_PRESSED && !c.isEmergencyStopped) {
+                            // Bypass the periodic sending; the repetitions compensate for lost datagrams.
+                            c.isEmergencyStopped = true;
+                            c.changedAr.acceleration(DECELERATION_MAX).steering(0).isValid(false);
+                            const int64_t PRESSED_IN_MICROSECONDS{c.inputEvents.buttonSampleTimesInMicroseconds[BUTTON]};
+                            for (uint32_t n{0}; n < ESTOP_REPEAT; n++) {
+                                send(changedArEncoder.encode(c.changedAr, cluon::time::fromMicroseconds(PRESSED_IN_MICROSECONDS), c.senderStamp));
+                            }
+                            const int64_t NOW{cluon::time::toMicroseconds(cluon::time::now())};
+                            c.lastChangeSentInMicroseconds = NOW;
+                            if (HAS_STATISTICS && (0 != PRESSED_IN_MICROSECONDS)) {
+                                emergencyStopLatency.record(static_cast<uint64_t>(std::max<int64_t>(NOW - PRESSED_IN_MICROSECONDS, 0)));
+                            }
+                            if (probe && (0 != PRESSED_IN_MICROSECONDS)) {
+                                probe->sent(c.senderStamp, PRESSED_IN_MICROSECONDS, NOW);
+                            }
+                            std::clog << "[opendlv-device-ps3controller]: Emergency stop engaged for sender stamp " << c.senderStamp << "." << std::endl;
+                        }
+                        else if (!IS_PRESSED && c.isEmergencyStopped && (std::fabs(c.acceleration) < 0.001f)) {
+                            c.isEmergencyStopped = false;
+                            std::clog << "[opendlv-device-ps3controller]: Emergency stop released for sender stamp " << c.senderStamp << "." << std::endl;
+                        }
+                    }
+
+                    // Send with the full frequency right away once the values change.
+                    if ( ADAPTIVE && ((std::fabs(c.steering - PREVIOUS_STEERING) > 0.001f) || (std::fabs(c.acceleration - PREVIOUS_ACCELERATION) > 0.001f) ||
+                                      (PUBLISH_GAMEPAD_STATE && (updatedAxes.any() || c.inputEvents.updatedButtons.any()))) ) {
+                        publisher.speedUp();
+                    }
+
+                    c.inputEvents.updatedAxes.reset();
+                    c.inputEvents.updatedButtons.reset();
+                    if (c.isEmergencyStopped) {
+                        store(c, ControllerState{DECELERATION_MAX, 0, c.sampleTimeInMicroseconds, false});
+                    }
+                    else {
+                        store(c, ControllerState{c.acceleration, c.steering, c.sampleTimeInMicroseconds, true});
+                    }
+                };
+
+                while (isRunning && !hasError) {
+                    constexpr int MAX_EVENTS{16};
+                    struct epoll_event events[MAX_EVENTS];
+                    const int NUMBER_OF_EVENTS{::epoll_wait(epollDescriptor, events, MAX_EVENTS, -1)};
+                    if ( (0 > NUMBER_OF_EVENTS) && (EINTR != errno) ) {
+                        std::cerr << "[opendlv-device-ps3controller]: Error while waiting for events: " << errno << ": " << strerror(errno) << std::endl;
+                        hasError = true;
+                    }
+
+                    for (int i{0}; i < NUMBER_OF_EVENTS; i++) {
+                        if (wakeupEvent == events[i].data.fd) {
+                            isRunning = false;
+                        }
+                        else if (sendTimer == events[i].data.fd) {
+                            // Consume the expiration; pending changes are handled below.
+                            uint64_t expirations{0};
+                            const ssize_t CONSUMED{::read(sendTimer, &expirations, sizeof(expirations))};
+                            (void)CONSUMED;
+                        }
+                        else if (HAS_FILTER && (filterTimer == events[i].data.fd)) {
+                            uint64_t expirations{0};
+                            const ssize_t CONSUMED{::read(filterTimer, &expirations, sizeof(expirations))};
+                            (void)CONSUMED;
+
+                            bool isSettled{true};
+                            for (const auto &controller : controllers) {
+                                Controller &c = *controller;
+                                if (c.inputDevice) {
+                                    const AxisFilter::Axes CHANGED{c.filter->step()};
+                                    for (uint32_t axis{0}; CHANGED.any() && (axis < InputEvents::MAX_NUMBER_OF_AXES); axis++) {
+                                        if (CHANGED.test(axis)) {
+                                            c.inputEvents.axisValues[axis] = c.filter->output(axis);
+                                            c.inputEvents.updatedAxes.set(axis);
                                         }
                                     }
-                                    break;
+                                    if (CHANGED.any()) {
+                                        process(c);
+                                    }
+                                    isSettled = isSettled && c.filter->isSettled();
+                                }
+                            }
+                            if (isSettled) {
+                                const struct itimerspec STOP{};
+                                ::timerfd_settime(filterTimer, 0, &STOP, nullptr);
+                                isFilterTimerArmed = false;
+                            }
+                        }
+                        else if (RECONNECT && (deviceWatch == events[i].data.fd)) {
+                            // Drain the notifications and try to reopen the disconnected devices they name;
+                            // a device may not be readable yet when it was just created, so failures are expected.
+                            alignas(struct inotify_event) char buffer[4096];
+                            ssize_t length{0};
+                            while (0 < (length = ::read(deviceWatch, buffer, sizeof(buffer)))) {
+                                for (ssize_t offset{0}; offset < length;) {
+                                    const struct inotify_event *EVENT{reinterpret_cast<const struct inotify_event*>(buffer + offset)};
+                                    offset += static_cast<ssize_t>(sizeof(struct inotify_event) + EVENT->len);
+                                    if (0 == EVENT->len) {
+                                        continue;
+                                    }
+                                    const std::string NAME{EVENT->name};
+                                    for (const auto &controller : controllers) {
+                                        const std::string &DEVICE_PATH{controller->device};
+                                        const std::size_t SLASH{DEVICE_PATH.rfind('/')};
+                                        if (controller->inputDevice || (NAME != ((std::string::npos == SLASH) ? DEVICE_PATH : DEVICE_PATH.substr(SLASH + 1)))) {
+                                            continue;
+                                        }
+                                        controller->inputDevice = openInputDevice(controller->device, false);
+                                        if (controller->inputDevice) {
+                                            std::clog << "[opendlv-device-ps3controller]: Reconnected " << controller->inputDevice->name() << " at " << controller->device << ", sender stamp: " << controller->senderStamp << std::endl;
+                                            store(*controller, ControllerState{0, 0, 0, true});
+                                            watch(controller->inputDevice->fileDescriptor());
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                        else {
+                            for (const auto &controller : controllers) {
+                                if (!controller->inputDevice || (controller->inputDevice->fileDescriptor() != events[i].data.fd)) {
+                                    continue;
                                 }
-                                case JS_EVENT_BUTTON:
+                                Controller &c = *controller;
+                                bool isDisconnected{0 != (events[i].events & (EPOLLERR | EPOLLHUP))};
+                                if (isDisconnected) {
+                                    std::cerr << "[opendlv-device-ps3controller]: Error: Device " << c.device << " was disconnected." << std::endl;
+                                }
+                                else if (!c.inputDevice->read(c.inputEvents)) {
+                                    isDisconnected = true;
+                                }
+                                if (isDisconnected && IS_REPLAY) {
+                                    // Keep sending the last replayed values until all controllers are finished.
+                                    c.inputDevice.reset();
+                                    isReplayFinished = std::none_of(controllers.begin(), controllers.end(), [](const std::unique_ptr<Controller> &other) { return static_cast<bool>(other->inputDevice); });
+                                    isRunning = !isReplayFinished;
                                     break;
-                                case JS_EVENT_INIT:
+                                }
+                                if (isDisconnected && RECONNECT) {
+                                    disconnect(c);
                                     break;
-                                default:
+                                }
+                                hasError = hasError || isDisconnected;
+                                if (hasError) {
                                     break;
+                                }
+                                if (HAS_STATISTICS) {
+                                    eventsPerWakeup.record(c.inputEvents.numberOfEvents);
+                                }
+                                c.inputEvents.numberOfEvents = 0;
+                                if (recorder) {
+                                    record(c);
+                                }
+                                if (c.filter) {
+                                    // Filtered axes are updated at the filter's rate.
+                                    const AxisFilter::Axes UPDATED{c.inputEvents.updatedAxes & c.filter->filteredAxes()};
+                                    for (uint32_t axis{0}; axis < InputEvents::MAX_NUMBER_OF_AXES; axis++) {
+                                        if (UPDATED.test(axis)) {
+                                            c.filter->input(axis, c.inputEvents.axisValues[axis]);
+                                            c.inputEvents.axisValues[axis] = c.filter->output(axis);
+                                        }
+                                    }
+                                    if (UPDATED.any()) {
+                                        armFilterTimer();
+                                    }
+                                }
+                                process(c);
                             }
                         }
-                        if (errno != EAGAIN) {
-                            std::cerr << "[opendlv-device-ps3controller]: Error: " << errno << ": " << strerror(errno) << std::endl;
-                            hasError = true;
+                    }
+
+                    if (PUBLISH_ON_CHANGE && !hasError) {
+                        // Wake up when the earliest pending change may be sent according to MAX_RATE.
+                        int64_t earliest{MIN_SEND_INTERVAL_IN_MICROSECONDS + 1};
+                        for (const auto &controller : controllers) {
+                            Controller &c = *controller;
+                            if (!c.inputDevice || c.isEmergencyStopped) {
+                                continue;
+                            }
+                            // A reconnected or released controller is valid again without moving.
+                            const bool HAS_PENDING_CHANGE{(std::fabs(c.changedAr.acceleration() - c.acceleration) > 0.001f) ||
+                                                          (std::fabs(c.changedAr.steering() - c.steering) > 0.001f) ||
+                                                          !c.changedAr.isValid()};
+                            const int64_t NOW{cluon::time::toMicroseconds(cluon::time::now())};
+                            const int64_t REMAINING{MIN_SEND_INTERVAL_IN_MICROSECONDS - (NOW - c.lastChangeSentInMicroseconds)};
+                            if (HAS_PENDING_CHANGE && (0 >= REMAINING)) {
+                                c.changedAr.acceleration(c.acceleration).steering(c.steering).isValid(true);
+                                send(changedArEncoder.encode(c.changedAr, cluon::time::fromMicroseconds(c.sampleTimeInMicroseconds), c.senderStamp));
+                                c.lastChangeSentInMicroseconds = NOW;
+                                if (HAS_STATISTICS && (0 != c.sampleTimeInMicroseconds)) {
+                                    const int64_t LATENCY{cluon::time::toMicroseconds(cluon::time::now()) - c.sampleTimeInMicroseconds};
+                                    inputToSendLatency.record(static_cast<uint64_t>(std::max<int64_t>(LATENCY, 0)));
+                                }
+                                if (probe && (0 != c.sampleTimeInMicroseconds)) {
+                                    probe->sent(c.senderStamp, c.sampleTimeInMicroseconds, NOW);
+                                }
+                            }
+                            else if (HAS_PENDING_CHANGE) {
+                                earliest = std::min(earliest, REMAINING);
+                            }
+                        }
+                        if (MIN_SEND_INTERVAL_IN_MICROSECONDS >= earliest) {
+                            struct itimerspec deadline{};
+                            deadline.it_value.tv_sec = earliest / (1000 * 1000);
+                            deadline.it_value.tv_nsec = (earliest % (1000 * 1000)) * 1000;
+                            ::timerfd_settime(sendTimer, 0, &deadline, nullptr);
                         }
                     }
                 }
+
+                if (-1 != epollDescriptor) {
+                    ::close(epollDescriptor);
+                }
+                if (-1 != sendTimer) {
+                    ::close(sendTimer);
+                }
+                if (-1 != deviceWatch) {
+                    ::close(deviceWatch);
+                }
+                if (-1 != filterTimer) {
+                    ::close(filterTimer);
+                }
             });
 
-            // OD4Session to send values to.
-            opendlv::proxy::ActuationRequest ar;
-            cluon::OD4Session od4{static_cast<uint16_t>(std::stoi(commandlineArguments["cid"]))};
-            if (od4.isRunning()) {
-                od4.timeTrigger(FREQ, [&VERBOSE,
-                                       &valuesMutex,
-                                       &acceleration,
-                                       &steering,
-                                       &hasError,
-                                       &ar,
-                                       &od4](){
-                    std::lock_guard<std::mutex> lck(valuesMutex);
-                    ar.acceleration(acceleration).steering(steering).isValid(!hasError);
-                    if (VERBOSE) {
-                        std::stringstream buffer;
-                        ar.accept([](uint32_t, const std::string &, const std::string &) {},
-                                 [&buffer](uint32_t, std::string &&, std::string &&n, auto v) { buffer << n << " = " << v << '\n'; },
-                                 []() {});
-                        std::cout << buffer.str() << std::endl;
-                    }
-                    od4.send(ar);
+            // Thread to read and send the motion sensors' samples.
+            int motionWakeupEvent{MOTION.empty() ? -1 : ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+            std::thread motionThread;
+            if (!MOTION.empty()) {
+                motionThread = std::thread([&MOTION, MOTION_BATCH, &ID, &send, &motionWakeupEvent, RECONNECT, RT_PRIORITY, READER_CPU]() {
+                    // Runs next to the reading thread but yields to it.
+                    if (0 < RT_PRIORITY) {
+                        setRealtimePriority(std::max(1, RT_PRIORITY - 1));
+                    }
+                    if (-1 < READER_CPU) {
+                        setCpuAffinity(READER_CPU);
+                    }
+
+                    EnvelopeEncoder<opendlv::proxy::MotionSamples, 2 * MotionDevice::MAX_NUMBER_OF_AXES * MAX_MOTION_BATCH + 64> motionSamplesEncoder;
+                    opendlv::proxy::MotionSamples motionSamples;
+                    uint32_t sequenceNumber{0};
+                    auto sendBatch = [&ID, &send, &motionSamplesEncoder, &motionSamples, &sequenceNumber](const MotionBatch &batch) {
+                        const uint32_t SAMPLE_PERIOD{(1 < batch.numberOfSamples) ? static_cast<uint32_t>((batch.lastSampleTimeInMicroseconds - batch.firstSampleTimeInMicroseconds) / (batch.numberOfSamples - 1)) : 0};
+                        motionSamples.sequenceNumber(sequenceNumber++).numberOfAxes(batch.numberOfAxes).numberOfSamples(batch.numberOfSamples).samplePeriod(SAMPLE_PERIOD).samples(batch.samples);
+                        send(motionSamplesEncoder.encode(motionSamples, cluon::time::fromMicroseconds(batch.firstSampleTimeInMicroseconds), ID));
+                    };
+                    auto closeMotionDevice = [](std::unique_ptr<MotionDevice> &motionDevice) {
+                        motionDevice->flush();
+                        if (0 < motionDevice->drops()) {
+                            std::clog << "[opendlv-device-ps3controller]: The kernel dropped motion samples " << motionDevice->drops() << " times." << std::endl;
+                        }
+                        motionDevice.reset();
+                    };
+
+                    // Like the controllers, the motion device is reopened once its device node reappears.
+                    const std::size_t SLASH{MOTION.rfind('/')};
+                    const std::string DIRECTORY{(std::string::npos == SLASH) ? "." : ((0 == SLASH) ? "/" : MOTION.substr(0, SLASH))};
+                    const std::string NAME{(std::string::npos == SLASH) ? MOTION : MOTION.substr(SLASH + 1)};
+                    int deviceWatch{RECONNECT ? ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC) : -1};
+                    if ( RECONNECT && ((-1 == deviceWatch) || (0 > ::inotify_add_watch(deviceWatch, DIRECTORY.c_str(), IN_CREATE | IN_ATTRIB | IN_MOVED_TO))) ) {
+                        std::cerr << "[opendlv-device-ps3controller]: Could not watch " << DIRECTORY << ": " << errno << ": " << strerror(errno) << std::endl;
+                        if (-1 != deviceWatch) {
+                            ::close(deviceWatch);
+                            deviceWatch = -1;
+                        }
+                    }
+
+                    std::unique_ptr<MotionDevice> motionDevice{openMotionDevice(MOTION, MOTION_BATCH, sendBatch)};
+                    if (motionDevice) {
+                        std::clog << "[opendlv-device-ps3controller]: Sending the motion sensors of " << motionDevice->name() << " at " << MOTION << " in batches of "
+                                  << MOTION_BATCH << " samples with sender stamp " << ID << "; " << motionDevice->describeAxes() << "." << std::endl;
+                    }
+                    else if (-1 != deviceWatch) {
+                        std::clog << "[opendlv-device-ps3controller]: Waiting for motion device " << MOTION << "." << std::endl;
+                    }
+
+                    bool isReading{motionDevice || (-1 != deviceWatch)};
+                    while (isReading) {
+                        // poll ignores the negative file descriptor while there is no motion device.
+                        struct pollfd fds[3]{{motionDevice ? motionDevice->fileDescriptor() : -1, POLLIN, 0}, {motionWakeupEvent, POLLIN, 0}, {deviceWatch, POLLIN, 0}};
+                        if ( (0 > ::poll(fds, 3, -1)) && (EINTR != errno) ) {
+                            isReading = false;
+                        }
+                        // The remaining samples are read before handling a disconnect.
+                        if ( motionDevice && (0 != (fds[0].revents & (POLLIN | POLLERR | POLLHUP))) &&
+                             (!motionDevice->read() || (0 != (fds[0].revents & (POLLERR | POLLHUP)))) ) {
+                            closeMotionDevice(motionDevice);
+                            if (-1 != deviceWatch) {
+                                std::cerr << "[opendlv-device-ps3controller]: Error: Motion device " << MOTION << " was disconnected; waiting for it to reconnect." << std::endl;
+                            }
+                            else {
+                                std::cerr << "[opendlv-device-ps3controller]: Error: Motion device " << MOTION << " was disconnected; its samples are not sent anymore." << std::endl;
+                                isReading = false;
+                            }
+                        }
+                        if (0 != (fds[2].revents & POLLIN)) {
+                            // Drain the notifications and try to reopen the motion device if they name it.
+                            alignas(struct inotify_event) char buffer[4096];
+                            ssize_t length{0};
+                            bool isNamed{false};
+                            while (0 < (length = ::read(deviceWatch, buffer, sizeof(buffer)))) {
+                                for (ssize_t offset{0}; offset < length;) {
+                                    const struct inotify_event *EVENT{reinterpret_cast<const struct inotify_event*>(buffer + offset)};
+                                    offset += static_cast<ssize_t>(sizeof(struct inotify_event) + EVENT->len);
+                                    isNamed = isNamed || ((0 < EVENT->len) && (NAME == EVENT->name));
+                                }
+                            }
+                            if (!motionDevice && isNamed) {
+                                motionDevice = openMotionDevice(MOTION, MOTION_BATCH, sendBatch, false);
+                                if (motionDevice) {
+                                    std::clog << "[opendlv-device-ps3controller]: Reconnected the motion sensors of " << motionDevice->name() << " at " << MOTION << "." << std::endl;
+                                }
+                            }
+                        }
+                        isReading = isReading && (0 == (fds[1].revents & POLLIN));
+                    }
+                    if (motionDevice) {
+                        closeMotionDevice(motionDevice);
+                    }
+                    if (-1 != deviceWatch) {
+                        ::close(deviceWatch);
+                    }
+                });
+            }
+
+            // Thread to report the timing statistics.
+            std::mutex statisticsMutex;
+            std::condition_variable statisticsCondition;
+            bool stopStatistics{false};
+            std::thread statisticsThread;
+            if (HAS_STATISTICS) {
+                statisticsThread = std::thread([&STATS,
+                                                &ID,
+                                                &send,
+                                                &statisticsMutex,
+                                                &statisticsCondition,
+                                                &stopStatistics,
+                                                &inputToSendLatency,
+                                                &tickJitter,
+                                                &eventsPerWakeup,
+                                                &handoffDuration,
+                                                &emergencyStopLatency,
+                                                &HAS_ESTOP,
+                                                &probe,
+                                                &publisher]() {
+                    const uint32_t INTERVAL_IN_MILLISECONDS{static_cast<uint32_t>(STATS * 1000.0f)};
+                    EnvelopeEncoder<opendlv::proxy::TimingStatistics> statisticsEncoder;
+                    opendlv::proxy::TimingStatistics ts;
+                    auto report = [&INTERVAL_IN_MILLISECONDS, &ID, &send, &statisticsEncoder, &ts](const std::string &name, const std::string &unit, LatencyHistogram &histogram) {
+                        const LatencyHistogram::Summary SUMMARY{histogram.summarizeAndReset()};
+                        std::clog << "[opendlv-device-ps3controller]: Statistics for " << name << " [" << unit << "]: count = " << SUMMARY.count
+                                  << ", min = " << SUMMARY.minimum << ", p50 = " << SUMMARY.median << ", p90 = " << SUMMARY.percentile90
+                                  << ", p99 = " << SUMMARY.percentile99 << ", p99.9 = " << SUMMARY.percentile999 << ", max = " << SUMMARY.maximum << std::endl;
+
+                        ts.name(name).unit(unit).interval(INTERVAL_IN_MILLISECONDS).count(SUMMARY.count)
+                          .minimum(SUMMARY.minimum).median(SUMMARY.median).percentile90(SUMMARY.percentile90)
+                          .percentile99(SUMMARY.percentile99).percentile999(SUMMARY.percentile999).maximum(SUMMARY.maximum);
+                        send(statisticsEncoder.encode(ts, cluon::data::TimeStamp(), ID));
+                    };
+
+                    uint64_t lastOverruns{0};
+                    std::unique_lock<std::mutex> lock(statisticsMutex);
+                    while (!statisticsCondition.wait_for(lock, std::chrono::milliseconds(INTERVAL_IN_MILLISECONDS), [&stopStatistics]() { return stopStatistics; })) {
+                        report("input-to-send latency", "us", inputToSendLatency);
+                        report("tick jitter", "us", tickJitter);
+                        report("events per wakeup", "events", eventsPerWakeup);
+                        report("state handoff", "ns", handoffDuration);
+                        if (HAS_ESTOP) {
+                            report("emergency stop latency", "us", emergencyStopLatency);
+                        }
+                        if (probe) {
+                            report("input-to-receive latency", "us", probe->inputToReceiveLatency());
+                            report("send-to-receive latency", "us", probe->sendToReceiveLatency());
+                            if (probe->hasEcho()) {
+                                report("round-trip latency", "us", probe->roundTripLatency());
+                            }
+                        }
+
+                        const uint64_t OVERRUNS{publisher.overruns()};
+                        if (OVERRUNS != lastOverruns) {
+                            std::clog << "[opendlv-device-ps3controller]: Missed " << (OVERRUNS - lastOverruns) << " time points for sending." << std::endl;
+                            lastOverruns = OVERRUNS;
+                        }
+                    }
+                });
+            }
+
+            // Locking the memory once all threads run faults in their stacks now instead
+            // of on first use on the hot paths; MCL_FUTURE locks later allocations when mapped.
+            if (MLOCKALL) {
+                lockMemory();
+            }
+
+            bool isReady{false};
+            if (batchSender.isOpen()) {
+                // Expected time between two ticks to determine their jitter.
+                const int64_t PERIOD_IN_MICROSECONDS{publisher.periodInNanoseconds() / 1000};
+                std::chrono::steady_clock::time_point lastTick{};
+                bool wasSlow{false};
+
+                // Time point of the last tick with changing values or values away from neutral.
+                std::chrono::steady_clock::time_point lastActivity{std::chrono::steady_clock::now()};
+                const std::chrono::steady_clock::duration IDLE_DURATION{std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(IDLE_TIME))};
+
+                // The sending runs in this thread; threads created before keep their scheduling.
+                if (0 < RT_PRIORITY) {
+                    setRealtimePriority(RT_PRIORITY);
+                }
+                if (-1 < PUBLISHER_CPU) {
+                    setCpuAffinity(PUBLISHER_CPU);
+                }
+
+                publisher.run([&verboseLog,
+                               &controllers,
+                               &hasError,
+                               &isReplayFinished,
+                               &arEncoder,
+                               &gamepadStateEncoder,
+                               &queue,
+                               &batchSender,
+                               PUBLISH_GAMEPAD_STATE,
+                               SUPPRESS_UNCHANGED,
+                               KEEPALIVE_TICKS,
+                               HAS_STATISTICS,
+                               &PERIOD_IN_MICROSECONDS,
+                               &lastTick,
+                               &wasSlow,
+                               ADAPTIVE,
+                               &lastActivity,
+                               &IDLE_DURATION,
+                               &publisher,
+                               &tickJitter,
+                               &handoffDuration,
+                               &inputToSendLatency,
+                               &probe,
+                               &isReady,
+                               &READY_FILE,
+                               &elapsedInMicroseconds,
+                               &ARGUMENTS_PARSED_IN_MICROSECONDS,
+                               &SAFE_STOP_SENT_IN_MICROSECONDS,
+                               &DEVICES_OPENED_IN_MICROSECONDS](){
+                    const std::chrono::steady_clock::time_point TICK{std::chrono::steady_clock::now()};
+                    // Intervals with the minimum frequency and early wake ups do not count as jitter.
+                    if (HAS_STATISTICS && (std::chrono::steady_clock::time_point{} != lastTick) && !wasSlow) {
+                        const int64_t INTERVAL{std::chrono::duration_cast<std::chrono::microseconds>(TICK - lastTick).count()};
+                        tickJitter.record(static_cast<uint64_t>(std::abs(INTERVAL - PERIOD_IN_MICROSECONDS)));
+                    }
+                    lastTick = TICK;
+                    wasSlow = publisher.isSlow();
+                    bool isActive{false};
+
+                    for (const auto &controller : controllers) {
+                        Controller &c = *controller;
+                        const std::chrono::steady_clock::time_point BEFORE_LOAD{std::chrono::steady_clock::now()};
+                        const ControllerState STATE{c.state.load()};
+                        if (HAS_STATISTICS) {
+                            handoffDuration.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - BEFORE_LOAD).count()));
+                        }
+                        // c.ar holds the values sent last.
+                        const bool IS_VALID{!hasError && STATE.isValid};
+                        const bool HAS_CHANGED{(std::fabs(c.ar.acceleration() - STATE.acceleration) > 0.001f) ||
+                                               (std::fabs(c.ar.steering() - STATE.steering) > 0.001f) ||
+                                               (c.ar.isValid() != IS_VALID)};
+                        ControllerInputs inputs{};
+                        bool hasChangedInputs{false};
+                        if (PUBLISH_GAMEPAD_STATE) {
+                            inputs = c.inputs.load();
+                            hasChangedInputs = (c.sentInputs.buttons != inputs.buttons) ||
+                                               (c.sentInputs.numberOfAxes != inputs.numberOfAxes) ||
+                                               !std::equal(inputs.axes.begin(), inputs.axes.begin() + inputs.numberOfAxes, c.sentInputs.axes.begin());
+                        }
+                        isActive = isActive || HAS_CHANGED || hasChangedInputs || (std::fabs(STATE.acceleration) > 0.001f) || (std::fabs(STATE.steering) > 0.001f);
+                        c.ticksSinceLastSend++;
+                        if (!SUPPRESS_UNCHANGED || HAS_CHANGED || hasChangedInputs || (c.ticksSinceLastSend >= KEEPALIVE_TICKS)) {
+                            c.ticksSinceLastSend = 0;
+                            c.ar.acceleration(STATE.acceleration).steering(STATE.steering).isValid(IS_VALID);
+                            if (verboseLog) {
+                                VerboseLog::Record entry;
+                                entry.kind = VerboseLog::Record::SENT;
+                                entry.timeInMicroseconds = cluon::time::toMicroseconds(cluon::time::now());
+                                entry.acceleration = STATE.acceleration;
+                                entry.steering = STATE.steering;
+                                entry.isValid = IS_VALID;
+                                verboseLog->fromSendingThread(entry);
+                            }
+                            queue(arEncoder.encode(c.ar, cluon::time::fromMicroseconds(STATE.sampleTimeInMicroseconds), c.senderStamp));
+                            c.lastSentInMicroseconds = cluon::time::toMicroseconds(cluon::time::now());
+
+                            if (PUBLISH_GAMEPAD_STATE) {
+                                // Pack the axes as little endian int16 into the preallocated string.
+                                c.packedAxes.resize(2 * inputs.numberOfAxes);
+                                for (uint16_t axis{0}; axis < inputs.numberOfAxes; axis++) {
+                                    const uint16_t VALUE{htole16(static_cast<uint16_t>(inputs.axes[axis]))};
+                                    std::memcpy(&c.packedAxes[2 * axis], &VALUE, sizeof(VALUE));
+                                }
+                                c.gamepadState.numberOfAxes(inputs.numberOfAxes).axes(c.packedAxes).numberOfButtons(inputs.numberOfButtons).buttons(inputs.buttons);
+                                queue(gamepadStateEncoder.encode(c.gamepadState, cluon::time::fromMicroseconds(inputs.sampleTimeInMicroseconds), c.senderStamp));
+                                c.sentInputs = inputs;
+                            }
+
+                            // Only the first message carrying a new sample contributes to the latency.
+                            if (HAS_STATISTICS && (0 != STATE.sampleTimeInMicroseconds) && (c.lastRecordedSampleTimeInMicroseconds != STATE.sampleTimeInMicroseconds)) {
+                                const int64_t LATENCY{c.lastSentInMicroseconds - STATE.sampleTimeInMicroseconds};
+                                inputToSendLatency.record(static_cast<uint64_t>(std::max<int64_t>(LATENCY, 0)));
+                                c.lastRecordedSampleTimeInMicroseconds = STATE.sampleTimeInMicroseconds;
+                                if (probe) {
+                                    probe->sent(c.senderStamp, STATE.sampleTimeInMicroseconds, c.lastSentInMicroseconds);
+                                }
+                            }
+                        }
+                    }
+
+                    batchSender.flush();
+
+                    if (ADAPTIVE) {
+                        if (isActive) {
+                            lastActivity = TICK;
+                            publisher.speedUp();
+                        }
+                        else if (TICK - lastActivity >= IDLE_DURATION) {
+                            publisher.slowDown();
+                        }
+                    }
+
+                    if (!isReady) {
+                        isReady = true;
+                        const int64_t READY_IN_MICROSECONDS{elapsedInMicroseconds()};
+                        notifyReady(READY_FILE, "Sending values of " + std::to_string(controllers.size()) + " controller(s).");
+                        std::clog << "[opendlv-device-ps3controller]: Startup: arguments parsed after " << ARGUMENTS_PARSED_IN_MICROSECONDS
+                                  << " us, safe stop sent after " << SAFE_STOP_SENT_IN_MICROSECONDS << " us, devices opened after "
+                                  << DEVICES_OPENED_IN_MICROSECONDS << " us, first values sent after " << READY_IN_MICROSECONDS << " us." << std::endl;
+                    }
 
                     // Determine whether to continue or not.
-                    return !hasError;
+                    return !hasError && !isReplayFinished;
                 });
+            }
+
+            // Wake up the reading thread to stop reading.
+            const uint64_t STOP{1};
+            if (0 > ::write(wakeupEvent, &STOP, sizeof(STOP))) {
+                std::cerr << "[opendlv-device-ps3controller]: Could not stop reading thread: " << errno << ": " << strerror(errno) << std::endl;
+            }
+            ps3controllerReadingThread.join();
+            ::close(wakeupEvent);
+            if (motionThread.joinable()) {
+                if (0 > ::write(motionWakeupEvent, &STOP, sizeof(STOP))) {
+                    std::cerr << "[opendlv-device-ps3controller]: Could not stop motion thread: " << errno << ": " << strerror(errno) << std::endl;
+                }
+                motionThread.join();
+                ::close(motionWakeupEvent);
+            }
+
+            // Send stop once no other thread can send anymore.
+            if (batchSender.isOpen()) {
+                for (const auto &controller : controllers) {
+                    controller->ar.acceleration(0).steering(0).isValid(true);
+                    queue(arEncoder.encode(controller->ar, cluon::data::TimeStamp(), controller->senderStamp));
+                }
+                batchSender.flush();
+                if (isReady) {
+                    notifyStopping(READY_FILE);
+                }
+            }
+
+            // Tell local readers that the values are not updated anymore.
+            for (const auto &controller : controllers) {
+                store(*controller, ControllerState{0, 0, 0, false});
+            }
 
-                // Send stop.
-                ar.acceleration(0).steering(0).isValid(true);
-                od4.send(ar);
+            if (statisticsThread.joinable()) {
+                {
+                    std::lock_guard<std::mutex> lock(statisticsMutex);
+                    stopStatistics = true;
+                }
+                statisticsCondition.notify_all();
+                statisticsThread.join();
             }
-            ::close(ps3controllerDevice);
             retCode = 0;
         }
     }
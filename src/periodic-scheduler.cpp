@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cluon-complete.hpp"
+#include "periodic-scheduler.hpp"
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <ctime>
+
+namespace {
+    int64_t nowInNanoseconds() noexcept {
+        struct timespec now{};
+        ::clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<int64_t>(now.tv_sec) * 1000 * 1000 * 1000 + static_cast<int64_t>(now.tv_nsec);
+    }
+
+    int64_t periodOf(float freq) noexcept {
+        return std::llround(1000.0 * 1000.0 * 1000.0 / ((freq > 0) ? static_cast<double>(freq) : 1.0));
+    }
+}
+
+PeriodicScheduler::PeriodicScheduler(float freq, float minimumFreq) noexcept
+    : m_periodInNanoseconds{periodOf(freq)}
+    , m_slowPeriodInNanoseconds{((minimumFreq > 0) && (minimumFreq < freq)) ? periodOf(minimumFreq) : periodOf(freq)}
+    // A timer can be woken up early from another thread unlike clock_nanosleep.
+    , m_timer{::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)} {}
+
+PeriodicScheduler::~PeriodicScheduler() {
+    if (-1 != m_timer) {
+        ::close(m_timer);
+    }
+}
+
+void PeriodicScheduler::run(std::function<bool()> delegate) noexcept {
+    if ( (nullptr != delegate) && (-1 != m_timer) ) {
+        bool delegateIsRunning{true};
+        int64_t deadline{nowInNanoseconds()};
+        do {
+            try {
+                delegateIsRunning = delegate();
+            } catch (...) {
+                delegateIsRunning = false; // delegate threw exception.
+            }
+
+            const bool IS_SLOW{m_isSlow.load()};
+            const int64_t PERIOD{IS_SLOW ? m_slowPeriodInNanoseconds : m_periodInNanoseconds};
+            deadline += PERIOD;
+            const int64_t LATENESS{nowInNanoseconds() - deadline};
+            if (0 < LATENESS) {
+                // Stay on the grid of time points instead of catching up.
+                const int64_t MISSED{LATENESS / PERIOD + 1};
+                m_overruns += static_cast<uint64_t>(MISSED);
+                deadline += MISSED * PERIOD;
+            }
+
+            wakeUpAt(deadline);
+            if (IS_SLOW && !m_isSlow.load()) {
+                // speedUp was called before the timer was set to the slow deadline.
+                wakeUpAt(nowInNanoseconds());
+            }
+            uint64_t expirations{0};
+            while ( (0 > ::read(m_timer, &expirations, sizeof(expirations))) && (EINTR == errno) &&
+                    !cluon::TerminateHandler::instance().isTerminated.load() ) {}
+
+            // Continue on the grid from an early wake up.
+            const int64_t NOW{nowInNanoseconds()};
+            deadline = (NOW < deadline) ? NOW : deadline;
+        } while (delegateIsRunning && !cluon::TerminateHandler::instance().isTerminated.load());
+    }
+}
+
+void PeriodicScheduler::slowDown() noexcept {
+    if (m_slowPeriodInNanoseconds != m_periodInNanoseconds) {
+        m_isSlow.store(true);
+    }
+}
+
+void PeriodicScheduler::speedUp() noexcept {
+    if (m_isSlow.load(std::memory_order_relaxed) && m_isSlow.exchange(false)) {
+        wakeUpAt(nowInNanoseconds());
+    }
+}
+
+bool PeriodicScheduler::isSlow() const noexcept {
+    return m_isSlow.load();
+}
+
+int64_t PeriodicScheduler::periodInNanoseconds() const noexcept {
+    return m_periodInNanoseconds;
+}
+
+int64_t PeriodicScheduler::slowPeriodInNanoseconds() const noexcept {
+    return m_slowPeriodInNanoseconds;
+}
+
+uint64_t PeriodicScheduler::overruns() const noexcept {
+    return m_overruns.load();
+}
+
+void PeriodicScheduler::wakeUpAt(int64_t timePointInNanoseconds) noexcept {
+    // An absolute time point in the past expires right away; 0 would disarm the timer.
+    struct itimerspec wakeup{};
+    wakeup.it_value.tv_sec = static_cast<time_t>(timePointInNanoseconds / (1000 * 1000 * 1000));
+    wakeup.it_value.tv_nsec = static_cast<long>(timePointInNanoseconds % (1000 * 1000 * 1000));
+    if ( (0 == wakeup.it_value.tv_sec) && (0 == wakeup.it_value.tv_nsec) ) {
+        wakeup.it_value.tv_nsec = 1;
+    }
+    ::timerfd_settime(m_timer, TFD_TIMER_ABSTIME, &wakeup, nullptr);
+}
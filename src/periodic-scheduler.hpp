@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PERIODIC_SCHEDULER_HPP
+#define PERIODIC_SCHEDULER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+/**
+ * This class calls a delegate periodically at absolute time points on
+ * CLOCK_MONOTONIC: Unlike OD4Session::timeTrigger, the period is not rounded
+ * to milliseconds and the delegate's runtime does not accumulate as drift.
+ * Time points missed because the delegate ran too long are skipped and
+ * counted as overruns.
+ *
+ * With a minimum frequency, the delegate can call slowDown to continue with
+ * the longer period while there is nothing to do; speedUp returns to the
+ * frequency given first and wakes up a slowed down scheduler right away.
+ */
+class PeriodicScheduler {
+   private:
+    PeriodicScheduler(const PeriodicScheduler &) = delete;
+    PeriodicScheduler(PeriodicScheduler &&)      = delete;
+    PeriodicScheduler &operator=(const PeriodicScheduler &) = delete;
+    PeriodicScheduler &operator=(PeriodicScheduler &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param freq Frequency in Hz to call the delegate with.
+     * @param minimumFreq Frequency in Hz to call the delegate with after slowDown; 0 = never slow down.
+     */
+    explicit PeriodicScheduler(float freq, float minimumFreq = 0.0f) noexcept;
+    ~PeriodicScheduler();
+
+    /**
+     * This method calls the given delegate until it returns false or the
+     * program is terminated.
+     *
+     * @param delegate Function to call periodically.
+     */
+    void run(std::function<bool()> delegate) noexcept;
+
+    /**
+     * This method continues with the minimum frequency if one was given.
+     */
+    void slowDown() noexcept;
+
+    /**
+     * This method continues with the frequency given first; it can be called
+     * from any thread.
+     */
+    void speedUp() noexcept;
+
+    /**
+     * @return true if the scheduler runs with the minimum frequency.
+     */
+    bool isSlow() const noexcept;
+
+    /**
+     * @return Period in nanoseconds.
+     */
+    int64_t periodInNanoseconds() const noexcept;
+
+    /**
+     * @return Period in nanoseconds after slowDown.
+     */
+    int64_t slowPeriodInNanoseconds() const noexcept;
+
+    /**
+     * @return Number of time points missed so far.
+     */
+    uint64_t overruns() const noexcept;
+
+   private:
+    void wakeUpAt(int64_t timePointInNanoseconds) noexcept;
+
+   private:
+    const int64_t m_periodInNanoseconds;
+    const int64_t m_slowPeriodInNanoseconds;
+    int m_timer{-1};
+    std::atomic<bool> m_isSlow{false};
+    std::atomic<uint64_t> m_overruns{0};
+};
+
+#endif
@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cluon-complete.hpp"
+#include "actuationrequestmessage.hpp"
+#include "axis-mapping.hpp"
+#include "envelope-encoder.hpp"
+#include "joystick-device.hpp"
+#include "seqlock.hpp"
+
+#include <fcntl.h>
+#include <linux/joystick.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+// This program measures the stages between reading a controller and sending
+// an ActuationRequest in isolation and end to end with a synthetic js_event
+// stream fed through a pipe: the reference implementations reflect the
+// original code (one read per event, mapping computed per event, mutex and
+// cluon::serializeEnvelope), the others the code that is used now.
+
+namespace {
+    // Counts all allocations of this process.
+    std::atomic<uint64_t> numberOfAllocations{0};
+}
+
+void *operator new(std::size_t size) {
+    numberOfAllocations++;
+    void *p{std::malloc((0 == size) ? 1 : size)};
+    if (nullptr == p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+// Not inlined so that GCC does not pair std::free with its built-in operator new.
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    const float STEERING_MIN{-10.0f};
+    const float STEERING_MAX{10.0f};
+    const float ACCELERATION_MIN{0.0f};
+    const float ACCELERATION_MAX{50.0f};
+    const float DECELERATION_MIN{0.0f};
+    const float DECELERATION_MAX{-10.0f};
+    const uint8_t STEERING_AXIS{0};
+    const uint8_t ACCELERATION_AXIS{4};
+
+    // Values generated in the benchmarks are accumulated here so that they are not optimized away.
+    volatile float sink{0};
+
+    struct State {
+        float acceleration{0};
+        float steering{0};
+        int64_t sampleTimeInMicroseconds{0};
+        bool isValid{true};
+    };
+
+    // Alternating steering and acceleration events with every 16th event being a button.
+    std::vector<struct js_event> syntheticEvents(std::size_t numberOfEvents) {
+        std::vector<struct js_event> events(numberOfEvents);
+        uint32_t random{12345};
+        for (std::size_t i{0}; i < numberOfEvents; i++) {
+            random = random * 1664525u + 1013904223u;
+            struct js_event &js = events[i];
+            js.time = static_cast<uint32_t>(i);
+            if (15 == (i % 16)) {
+                js.type = JS_EVENT_BUTTON;
+                js.number = 3;
+                js.value = static_cast<int16_t>((i / 16) % 2);
+            }
+            else {
+                js.type = JS_EVENT_AXIS;
+                js.number = (0 == (i % 2)) ? STEERING_AXIS : ACCELERATION_AXIS;
+                js.value = static_cast<int16_t>(random >> 16);
+            }
+        }
+        return events;
+    }
+
+    void report(const std::string &name, uint64_t numberOfOperations, std::chrono::nanoseconds duration, uint64_t allocations) {
+        const double NANOSECONDS{static_cast<double>(duration.count()) / static_cast<double>(numberOfOperations)};
+        std::cout << std::left << std::setw(48) << name << std::right << std::fixed
+                  << std::setw(10) << std::setprecision(1) << NANOSECONDS << " ns/op"
+                  << std::setw(10) << std::setprecision(2) << static_cast<double>(allocations) / static_cast<double>(numberOfOperations) << " allocs/op"
+                  << std::setw(14) << std::setprecision(0) << 1000.0 * 1000.0 * 1000.0 / NANOSECONDS << " op/s" << std::endl;
+    }
+
+    // Runs f n times and reports its duration and allocations per call.
+    template <typename F>
+    void measure(const std::string &name, uint64_t n, F &&f) {
+        const uint64_t ALLOCATIONS{numberOfAllocations.load()};
+        const std::chrono::steady_clock::time_point START{std::chrono::steady_clock::now()};
+        for (uint64_t i{0}; i < n; i++) {
+            f(i);
+        }
+        const std::chrono::steady_clock::time_point END{std::chrono::steady_clock::now()};
+        report(name, n, END - START, numberOfAllocations.load() - ALLOCATIONS);
+    }
+
+    // Feeds the events through a pipe in chunks and reports the time spent in drain per event.
+    template <typename DRAIN>
+    void measureDecoding(const std::string &name, const std::vector<struct js_event> &events, int writing, int reading, DRAIN &&drain) {
+        const std::size_t CHUNK{4096};
+        std::chrono::nanoseconds duration{0};
+        const uint64_t ALLOCATIONS{numberOfAllocations.load()};
+        for (std::size_t offset{0}; offset < events.size(); offset += CHUNK) {
+            const std::size_t LENGTH{std::min(CHUNK, events.size() - offset) * sizeof(struct js_event)};
+            const ssize_t WRITTEN{::write(writing, events.data() + offset, LENGTH)};
+            (void)WRITTEN;
+            const std::chrono::steady_clock::time_point START{std::chrono::steady_clock::now()};
+            drain(reading);
+            duration += std::chrono::steady_clock::now() - START;
+        }
+        report(name, events.size(), duration, numberOfAllocations.load() - ALLOCATIONS);
+    }
+
+    // Mapping as it was computed for every event originally.
+    float referenceSteering(int16_t value) noexcept {
+        const float percent{static_cast<float>(value - (-32768)) / static_cast<float>(32767 - (-32768)) * 100.0f};
+        float steering{percent / 100.0f * (STEERING_MAX - STEERING_MIN) + STEERING_MIN};
+        steering *= -1.0f;
+        steering = ::roundf(4.0f * steering) / 4.0f;
+        if (steering < 0.001f && steering > -0.001f) {
+            steering = 0;
+        }
+        return steering;
+    }
+
+    float referenceAcceleration(int16_t value) noexcept {
+        const float percent{static_cast<float>(value - (-32768)) / static_cast<float>(32767 - (-32768)) * 100.0f};
+        float acceleration{(value < 0) ? (100.0f - 2.0f * percent) / 100.0f * (ACCELERATION_MAX - ACCELERATION_MIN) + ACCELERATION_MIN
+                                       : (2.0f * percent - 100.0f) / 100.0f * (DECELERATION_MAX - DECELERATION_MIN)};
+        acceleration = ::roundf(4.0f * acceleration) / 4.0f;
+        if (acceleration < 0.001f && acceleration > -0.001f) {
+            acceleration = 0;
+        }
+        return acceleration;
+    }
+
+    // Serialization as done by cluon::OD4Session::send.
+    std::string referenceEncode(opendlv::proxy::ActuationRequest &ar, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t senderStamp) {
+        cluon::ToProtoVisitor protoEncoder;
+        cluon::data::Envelope envelope;
+        envelope.dataType(static_cast<int32_t>(ar.ID()));
+        ar.accept(protoEncoder);
+        envelope.serializedData(protoEncoder.encodedData());
+        envelope.sent(cluon::time::now());
+        envelope.sampleTimeStamp((0 == (sampleTimeStamp.seconds() + sampleTimeStamp.microseconds())) ? envelope.sent() : sampleTimeStamp);
+        envelope.senderStamp(senderStamp);
+        return cluon::serializeEnvelope(std::move(envelope));
+    }
+}
+
+int32_t main(int32_t argc, char **argv) {
+    auto commandlineArguments = cluon::getCommandlineArguments(argc, argv);
+    const uint64_t EVENTS{(commandlineArguments.count("events") != 0) ? static_cast<uint64_t>(std::stoull(commandlineArguments["events"])) : 1000000};
+    if (0 == EVENTS) {
+        std::cerr << argv[0] << " measures the stages of opendlv-device-ps3controller with synthetic controller events." << std::endl;
+        std::cerr << "Usage:   " << argv[0] << " [--events=<number of events per benchmark; default: 1000000>]" << std::endl;
+        return 1;
+    }
+
+    const std::vector<struct js_event> EVENT_STREAM{syntheticEvents(static_cast<std::size_t>(EVENTS))};
+    int fds[2]{-1, -1};
+    if (0 != ::pipe2(fds, O_NONBLOCK | O_CLOEXEC)) {
+        std::cerr << "[ps3controller-bench]: Could not create pipe: " << errno << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    const int WRITING{fds[1]};
+    // The device owns and closes the reading end.
+    JoystickDevice device{fds[0]};
+    InputEvents inputEvents;
+
+    std::cout << "Decoding" << std::endl;
+    measureDecoding("  one read per js_event (reference)", EVENT_STREAM, WRITING, device.fileDescriptor(), [&inputEvents](int fd) {
+        struct js_event js;
+        while (::read(fd, &js, sizeof(struct js_event)) > 0) {
+            if (JS_EVENT_AXIS == (js.type & ~JS_EVENT_INIT)) {
+                inputEvents.axisValues[js.number] = js.value;
+            }
+        }
+    });
+    measureDecoding("  JoystickDevice::read", EVENT_STREAM, WRITING, device.fileDescriptor(), [&device, &inputEvents](int) {
+        device.read(inputEvents);
+    });
+
+    std::cout << "Mapping" << std::endl;
+    const AxisMapping steeringMapping{[](float percent) {
+                                          return -1.0f * (percent / 100.0f * (STEERING_MAX - STEERING_MIN) + STEERING_MIN);
+                                      }, AxisMapping::Curve{}};
+    const AxisMapping accelerationMapping{[](float percent) {
+                                              return (percent < 50.0f) ? (100.0f - 2.0f * percent) / 100.0f * (ACCELERATION_MAX - ACCELERATION_MIN) + ACCELERATION_MIN
+                                                                       : (2.0f * percent - 100.0f) / 100.0f * (DECELERATION_MAX - DECELERATION_MIN);
+                                          }, AxisMapping::Curve{}};
+    measure("  computed per event (reference)", EVENTS, [&EVENT_STREAM](uint64_t i) {
+        const struct js_event &js = EVENT_STREAM[i];
+        sink = sink + ((STEERING_AXIS == js.number) ? referenceSteering(js.value) : referenceAcceleration(js.value));
+    });
+    measure("  AxisMapping::map", EVENTS, [&EVENT_STREAM, &steeringMapping, &accelerationMapping](uint64_t i) {
+        const struct js_event &js = EVENT_STREAM[i];
+        sink = sink + ((STEERING_AXIS == js.number) ? steeringMapping.map(js.value) : accelerationMapping.map(js.value));
+    });
+
+    std::cout << "Handoff between threads (uncontended)" << std::endl;
+    std::mutex stateMutex;
+    State guardedState;
+    measure("  std::mutex (reference)", EVENTS, [&stateMutex, &guardedState](uint64_t i) {
+        {
+            std::lock_guard<std::mutex> lck(stateMutex);
+            guardedState.steering = static_cast<float>(i);
+        }
+        std::lock_guard<std::mutex> lck(stateMutex);
+        sink = sink + guardedState.steering;
+    });
+    SeqLock<State> sharedState;
+    measure("  SeqLock", EVENTS, [&sharedState](uint64_t i) {
+        sharedState.store(State{0, static_cast<float>(i), 0, true});
+        sink = sink + sharedState.load().steering;
+    });
+
+    std::cout << "Encoding" << std::endl;
+    opendlv::proxy::ActuationRequest ar;
+    measure("  cluon::serializeEnvelope (reference)", EVENTS, [&ar](uint64_t i) {
+        ar.acceleration(static_cast<float>(i % 50)).steering(-2.5f).isValid(true);
+        sink = sink + static_cast<float>(referenceEncode(ar, cluon::time::fromMicroseconds(static_cast<int64_t>(i)), 0).size());
+    });
+    EnvelopeEncoder<opendlv::proxy::ActuationRequest> arEncoder;
+    measure("  EnvelopeEncoder", EVENTS, [&ar, &arEncoder](uint64_t i) {
+        ar.acceleration(static_cast<float>(i % 50)).steering(-2.5f).isValid(true);
+        sink = sink + static_cast<float>(arEncoder.encode(ar, cluon::time::fromMicroseconds(static_cast<int64_t>(i)), 0).size());
+    });
+
+    // Each drained chunk is mapped, handed over and encoded once like on-change sending does.
+    std::cout << "End to end (one message per drained chunk)" << std::endl;
+    measureDecoding("  reference", EVENT_STREAM, WRITING, device.fileDescriptor(), [&stateMutex, &guardedState, &ar](int fd) {
+        struct js_event js;
+        while (::read(fd, &js, sizeof(struct js_event)) > 0) {
+            if (JS_EVENT_AXIS == (js.type & ~JS_EVENT_INIT)) {
+                std::lock_guard<std::mutex> lck(stateMutex);
+                if (STEERING_AXIS == js.number) {
+                    guardedState.steering = referenceSteering(js.value);
+                }
+                if (ACCELERATION_AXIS == js.number) {
+                    guardedState.acceleration = referenceAcceleration(js.value);
+                }
+            }
+        }
+        State state;
+        {
+            std::lock_guard<std::mutex> lck(stateMutex);
+            state = guardedState;
+        }
+        ar.acceleration(state.acceleration).steering(state.steering).isValid(state.isValid);
+        sink = sink + static_cast<float>(referenceEncode(ar, cluon::data::TimeStamp(), 0).size());
+    });
+    measureDecoding("  current", EVENT_STREAM, WRITING, device.fileDescriptor(), [&device, &inputEvents, &steeringMapping, &accelerationMapping, &sharedState, &ar, &arEncoder](int) {
+        device.read(inputEvents);
+        State state;
+        if (inputEvents.updatedAxes.test(STEERING_AXIS)) {
+            state.steering = steeringMapping.map(inputEvents.axisValues[STEERING_AXIS]);
+        }
+        if (inputEvents.updatedAxes.test(ACCELERATION_AXIS)) {
+            state.acceleration = accelerationMapping.map(inputEvents.axisValues[ACCELERATION_AXIS]);
+        }
+        inputEvents.updatedAxes.reset();
+        inputEvents.updatedButtons.reset();
+        sharedState.store(state);
+
+        const State SENT{sharedState.load()};
+        ar.acceleration(SENT.acceleration).steering(SENT.steering).isValid(SENT.isValid);
+        sink = sink + static_cast<float>(arEncoder.encode(ar, cluon::data::TimeStamp(), 0).size());
+    });
+
+    ::close(WRITING);
+    return 0;
+}
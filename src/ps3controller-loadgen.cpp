@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cluon-complete.hpp"
+
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// This program creates a virtual joystick with uinput and drives it with a
+// synthetic event stream at a given rate so that opendlv-device-ps3controller
+// can be run against the resulting /dev/input/jsN or /dev/input/eventN
+// device in soak tests beyond what human hands produce.
+
+namespace {
+    // Six axes numbered 0 to 5 by the joystick API like a PS3 controller's sticks and triggers.
+    const std::vector<uint16_t> AXES{ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY, ABS_RZ};
+    const std::vector<uint16_t> BUTTONS{BTN_SOUTH, BTN_EAST, BTN_NORTH, BTN_WEST, BTN_TL, BTN_TR, BTN_TL2, BTN_TR2,
+                                        BTN_SELECT, BTN_START, BTN_MODE, BTN_THUMBL, BTN_THUMBR};
+
+    struct Change {
+        uint16_t type{EV_ABS};
+        uint16_t number{0};
+        int32_t value{0};
+    };
+
+    // Script lines are "axis <number> <value>" or "button <number> <0|1>"; # starts a comment.
+    bool loadScript(const std::string &file, std::vector<Change> &changes) noexcept {
+        std::ifstream in(file);
+        if (!in.good()) {
+            std::cerr << "[ps3controller-loadgen]: Could not open " << file << "." << std::endl;
+            return false;
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            line = line.substr(0, line.find('#'));
+            std::istringstream sstr(line);
+            std::string kind;
+            uint32_t number{0};
+            int32_t value{0};
+            if (!(sstr >> kind)) {
+                continue;
+            }
+            if ( !(sstr >> number >> value) || (("axis" == kind) && (number >= AXES.size())) || (("button" == kind) && (number >= BUTTONS.size())) ||
+                 (("axis" != kind) && ("button" != kind)) ) {
+                std::cerr << "[ps3controller-loadgen]: Invalid line in " << file << ": " << line << std::endl;
+                return false;
+            }
+            Change change;
+            change.type = ("axis" == kind) ? EV_ABS : EV_KEY;
+            change.number = ("axis" == kind) ? AXES[number] : BUTTONS[number];
+            change.value = ("axis" == kind) ? std::max(-32768, std::min(32767, value)) : ((0 != value) ? 1 : 0);
+            changes.push_back(change);
+        }
+        if (changes.empty()) {
+            std::cerr << "[ps3controller-loadgen]: No events found in " << file << "." << std::endl;
+        }
+        return !changes.empty();
+    }
+
+    // The joystick and evdev nodes are children of the created input device in sysfs.
+    std::string listNodes(int fd) noexcept {
+        std::string nodes;
+        char sysname[64]{};
+        if (0 <= ::ioctl(fd, UI_GET_SYSNAME(sizeof(sysname)), sysname)) {
+            const std::string DIRECTORY{"/sys/devices/virtual/input/" + std::string(sysname)};
+            if (DIR *dir = ::opendir(DIRECTORY.c_str())) {
+                while (struct dirent *entry = ::readdir(dir)) {
+                    const std::string NAME{entry->d_name};
+                    if ( (0 == NAME.find("js")) || (0 == NAME.find("event")) ) {
+                        nodes += (nodes.empty() ? "" : ", ") + std::string("/dev/input/") + NAME;
+                    }
+                }
+                ::closedir(dir);
+            }
+        }
+        return nodes.empty() ? "unknown" : nodes;
+    }
+
+    void add(std::vector<struct input_event> &events, uint16_t type, uint16_t code, int32_t value) noexcept {
+        struct input_event ev{};
+        ev.type = type;
+        ev.code = code;
+        ev.value = value;
+        events.push_back(ev);
+    }
+}
+
+int32_t main(int32_t argc, char **argv) {
+    auto commandlineArguments = cluon::getCommandlineArguments(argc, argv);
+    const std::string MODE{(commandlineArguments.count("mode") != 0) ? commandlineArguments["mode"] : "random"};
+    const double RATE{(commandlineArguments.count("rate") != 0) ? std::stod(commandlineArguments["rate"]) : 1000.0};
+    const uint32_t BURST{(commandlineArguments.count("burst") != 0) ? static_cast<uint32_t>(std::stoi(commandlineArguments["burst"])) : 1};
+    const double DURATION{(commandlineArguments.count("duration") != 0) ? std::stod(commandlineArguments["duration"]) : 0.0};
+    const double START_DELAY{(commandlineArguments.count("start_delay") != 0) ? std::stod(commandlineArguments["start_delay"]) : 1.0};
+    const std::string SCRIPT{(commandlineArguments.count("script") != 0) ? commandlineArguments["script"] : ""};
+    const std::string NAME{(commandlineArguments.count("name") != 0) ? commandlineArguments["name"] : "ps3controller-loadgen"};
+    if ( (commandlineArguments.count("help") != 0) || !(RATE > 0) || (0 == BURST) || (("random" != MODE) && ("sweep" != MODE) && ("script" != MODE)) ||
+         (("script" == MODE) && SCRIPT.empty()) ) {
+        std::cerr << argv[0] << " creates a virtual joystick with uinput and drives it with synthetic events." << std::endl;
+        std::cerr << "Usage:   " << argv[0] << " [--mode=<random|sweep|script; default: random>] [--script=<file with axis <n> <value> or button <n> <0|1> lines, replayed in a loop; the input core drops lines that repeat an axis' or button's current value, which are not counted as sent>] [--rate=<changes per second; default: 1000>] [--burst=<changes per SYN_REPORT frame; default: 1>] [--duration=<s; default: 0 (until stopped)>] [--start_delay=<s to wait for readers after creating the device; default: 1>] [--name=<device name>]" << std::endl;
+        std::cerr << "Example: " << argv[0] << " --mode=random --rate=20000 --burst=4 --duration=60" << std::endl;
+        return 1;
+    }
+
+    std::vector<Change> script;
+    if ( ("script" == MODE) && !loadScript(SCRIPT, script) ) {
+        return 1;
+    }
+
+    const int fd{::open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC)};
+    if (-1 == fd) {
+        std::cerr << "[ps3controller-loadgen]: Could not open /dev/uinput: " << errno << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    bool isCreated{(0 <= ::ioctl(fd, UI_SET_EVBIT, EV_KEY)) && (0 <= ::ioctl(fd, UI_SET_EVBIT, EV_ABS)) && (0 <= ::ioctl(fd, UI_SET_EVBIT, EV_SYN))};
+    for (uint16_t button : BUTTONS) {
+        isCreated = isCreated && (0 <= ::ioctl(fd, UI_SET_KEYBIT, button));
+    }
+    for (uint16_t axis : AXES) {
+        struct uinput_abs_setup abs{};
+        abs.code = axis;
+        abs.absinfo.minimum = -32768;
+        abs.absinfo.maximum = 32767;
+        isCreated = isCreated && (0 <= ::ioctl(fd, UI_SET_ABSBIT, axis)) && (0 <= ::ioctl(fd, UI_ABS_SETUP, &abs));
+    }
+    struct uinput_setup setup{};
+    setup.id.bustype = BUS_VIRTUAL;
+    ::strncpy(setup.name, NAME.c_str(), sizeof(setup.name) - 1);
+    isCreated = isCreated && (0 <= ::ioctl(fd, UI_DEV_SETUP, &setup)) && (0 <= ::ioctl(fd, UI_DEV_CREATE));
+    if (!isCreated) {
+        std::cerr << "[ps3controller-loadgen]: Could not create the virtual joystick: " << errno << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        return 1;
+    }
+
+    // udev needs some time to create the device nodes.
+    cluon::TerminateHandler::instance();
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int64_t>(START_DELAY * 1000.0)));
+    std::clog << "[ps3controller-loadgen]: Created " << NAME << " at " << listNodes(fd) << "; sending " << RATE << " changes/s in " << MODE << " mode." << std::endl;
+
+    // Wake up every millisecond and catch up with the changes due until then.
+    const int timer{::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)};
+    struct itimerspec interval{};
+    interval.it_interval.tv_nsec = 1000 * 1000;
+    interval.it_value.tv_nsec = 1000 * 1000;
+    ::timerfd_settime(timer, 0, &interval, nullptr);
+
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int32_t> axisValue{-32768, 32767};
+    std::uniform_int_distribution<std::size_t> axisOrButton{0, AXES.size() + BUTTONS.size() - 1};
+    std::vector<int32_t> sweepValues(AXES.size(), 0);
+    std::vector<int32_t> sweepSteps(AXES.size(), 0);
+    for (std::size_t axis{0}; axis < AXES.size(); axis++) {
+        sweepSteps[axis] = static_cast<int32_t>(64 * (axis + 1));
+    }
+    std::vector<bool> pressed(BUTTONS.size(), false);
+
+    // A bounded number of changes is written per wakeup so that a stalled reader does not build up a backlog here.
+    const uint64_t MAX_CHANGES_PER_WAKEUP{std::max<uint64_t>(4096, BURST)};
+    std::vector<struct input_event> events;
+    events.reserve(MAX_CHANGES_PER_WAKEUP + MAX_CHANGES_PER_WAKEUP / BURST + 1);
+
+    // The input core drops events that repeat the current value of an axis or
+    // button, so they are tracked to count only the changes reaching readers.
+    std::array<int32_t, ABS_CNT> absValues{};
+    std::array<int32_t, KEY_CNT> keyValues{};
+    auto change = [&events, &absValues, &keyValues](uint16_t type, uint16_t code, int32_t value) {
+        int32_t &current = (EV_ABS == type) ? absValues[code] : keyValues[code];
+        const bool HAS_CHANGED{current != value};
+        current = value;
+        add(events, type, code, value);
+        return HAS_CHANGED;
+    };
+
+    const std::chrono::steady_clock::time_point START{std::chrono::steady_clock::now()};
+    std::chrono::steady_clock::time_point lastReport{START};
+    // Changes are paced by the generated ones, but only the written ones that changed a value are reported as sent.
+    uint64_t generated{0};
+    uint64_t sent{0};
+    uint64_t unchanged{0};
+    uint64_t skipped{0};
+    uint64_t failedWrites{0};
+    uint64_t sentAtLastReport{0};
+    std::size_t nextChange{0};
+    while (!cluon::TerminateHandler::instance().isTerminated.load()) {
+        uint64_t expirations{0};
+        if (0 > ::read(timer, &expirations, sizeof(expirations))) {
+            continue;
+        }
+        const std::chrono::steady_clock::time_point NOW{std::chrono::steady_clock::now()};
+        const double ELAPSED{std::chrono::duration<double>(NOW - START).count()};
+        if ( (DURATION > 0) && (ELAPSED >= DURATION) ) {
+            break;
+        }
+
+        const uint64_t DUE{static_cast<uint64_t>(RATE * ELAPSED) - generated - skipped};
+        if (DUE > MAX_CHANGES_PER_WAKEUP) {
+            skipped += DUE - MAX_CHANGES_PER_WAKEUP;
+        }
+        const uint64_t CHANGES{std::min(DUE, MAX_CHANGES_PER_WAKEUP)};
+
+        events.clear();
+        const std::array<int32_t, ABS_CNT> ABS_VALUES_BEFORE{absValues};
+        const std::array<int32_t, KEY_CNT> KEY_VALUES_BEFORE{keyValues};
+        uint64_t changed{0};
+        for (uint64_t i{0}; i < CHANGES; i++) {
+            if ("script" == MODE) {
+                changed += change(script[nextChange].type, script[nextChange].number, script[nextChange].value) ? 1 : 0;
+                nextChange = (nextChange + 1) % script.size();
+            }
+            else if ("sweep" == MODE) {
+                // Triangles with a different frequency per axis.
+                const std::size_t AXIS{nextChange};
+                nextChange = (nextChange + 1) % AXES.size();
+                if ( (sweepValues[AXIS] + sweepSteps[AXIS] > 32767) || (sweepValues[AXIS] + sweepSteps[AXIS] < -32768) ) {
+                    sweepSteps[AXIS] = -sweepSteps[AXIS];
+                }
+                sweepValues[AXIS] += sweepSteps[AXIS];
+                changed += change(EV_ABS, AXES[AXIS], sweepValues[AXIS]) ? 1 : 0;
+            }
+            else {
+                const std::size_t INDEX{axisOrButton(generator)};
+                if (INDEX < AXES.size()) {
+                    changed += change(EV_ABS, AXES[INDEX], axisValue(generator)) ? 1 : 0;
+                }
+                else {
+                    const std::size_t BUTTON{INDEX - AXES.size()};
+                    pressed[BUTTON] = !pressed[BUTTON];
+                    changed += change(EV_KEY, BUTTONS[BUTTON], pressed[BUTTON] ? 1 : 0) ? 1 : 0;
+                }
+            }
+            if ( (0 == ((generated + i + 1) % BURST)) || (i + 1 == CHANGES) ) {
+                add(events, EV_SYN, SYN_REPORT, 0);
+            }
+        }
+
+        if (!events.empty()) {
+            const std::size_t SIZE{events.size() * sizeof(struct input_event)};
+            if (static_cast<ssize_t>(SIZE) != ::write(fd, events.data(), SIZE)) {
+                // The device's values are unknown after a partial write; assume that none were changed.
+                failedWrites++;
+                absValues = ABS_VALUES_BEFORE;
+                keyValues = KEY_VALUES_BEFORE;
+            }
+            else {
+                sent += changed;
+                unchanged += CHANGES - changed;
+            }
+            generated += CHANGES;
+        }
+
+        if (NOW - lastReport >= std::chrono::seconds(1)) {
+            const double SECONDS{std::chrono::duration<double>(NOW - lastReport).count()};
+            std::clog << "[ps3controller-loadgen]: " << static_cast<uint64_t>(static_cast<double>(sent - sentAtLastReport) / SECONDS) << " changes/s, "
+                      << sent << " changes in total, " << unchanged << " unchanged, " << skipped << " skipped, " << failedWrites << " failed writes." << std::endl;
+            lastReport = NOW;
+            sentAtLastReport = sent;
+        }
+    }
+
+    std::clog << "[ps3controller-loadgen]: Sent " << sent << " changes in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - START).count()
+              << " s, " << unchanged << " unchanged, " << skipped << " skipped, " << failedWrites << " failed writes." << std::endl;
+    ::close(timer);
+    ::ioctl(fd, UI_DEV_DESTROY);
+    ::close(fd);
+    return 0;
+}
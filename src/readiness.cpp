@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "readiness.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    // Sends the given state to $NOTIFY_SOCKET without depending on libsystemd.
+    void notifySupervisor(const std::string &state) noexcept {
+        const char *NOTIFY_SOCKET{::getenv("NOTIFY_SOCKET")};
+        if ( (nullptr == NOTIFY_SOCKET) || ('\0' == NOTIFY_SOCKET[0]) ) {
+            return;
+        }
+
+        struct sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        const std::size_t LENGTH{::strnlen(NOTIFY_SOCKET, sizeof(address.sun_path))};
+        if (sizeof(address.sun_path) == LENGTH) {
+            std::cerr << "[opendlv-device-ps3controller]: NOTIFY_SOCKET is too long." << std::endl;
+            return;
+        }
+        std::memcpy(address.sun_path, NOTIFY_SOCKET, LENGTH);
+        // Names starting with @ denote Linux' abstract namespace.
+        if ('@' == address.sun_path[0]) {
+            address.sun_path[0] = '\0';
+        }
+
+        int s{::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0)};
+        if ( (-1 == s) ||
+             (0 > ::sendto(s, state.data(), state.size(), MSG_NOSIGNAL, reinterpret_cast<struct sockaddr *>(&address), static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + LENGTH))) ) {
+            std::cerr << "[opendlv-device-ps3controller]: Could not notify " << NOTIFY_SOCKET << ": " << errno << ": " << strerror(errno) << std::endl;
+        }
+        if (-1 != s) {
+            ::close(s);
+        }
+    }
+}
+
+void notifyReady(const std::string &readyFile, const std::string &status) noexcept {
+    notifySupervisor("READY=1\nSTATUS=" + status + "\nMAINPID=" + std::to_string(::getpid()));
+    if (!readyFile.empty()) {
+        std::ofstream file(readyFile, std::ios::out | std::ios::trunc);
+        file << ::getpid() << std::endl;
+        if (!file.good()) {
+            std::cerr << "[opendlv-device-ps3controller]: Could not create " << readyFile << "." << std::endl;
+        }
+    }
+}
+
+void notifyStopping(const std::string &readyFile) noexcept {
+    notifySupervisor("STOPPING=1");
+    if (!readyFile.empty()) {
+        ::unlink(readyFile.c_str());
+    }
+}
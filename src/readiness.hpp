@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef READINESS_HPP
+#define READINESS_HPP
+
+#include <string>
+
+/**
+ * This method tells a supervisor that the microservice is sending: systemd
+ * (or any other supervisor implementing its notification protocol) is
+ * notified through $NOTIFY_SOCKET if set, and the given file is created.
+ *
+ * @param readyFile File to create; empty to not create a file.
+ * @param status Human readable status to report.
+ */
+void notifyReady(const std::string &readyFile, const std::string &status) noexcept;
+
+/**
+ * This method tells a supervisor that the microservice is stopping and
+ * removes the given file.
+ *
+ * @param readyFile File created by notifyReady; empty if none was created.
+ */
+void notifyStopping(const std::string &readyFile) noexcept;
+
+#endif
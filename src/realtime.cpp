@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "realtime.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+bool setRealtimePriority(int32_t priority) noexcept {
+    struct sched_param sp{};
+    sp.sched_priority = priority;
+    // pthread_setschedparam returns the error instead of setting errno.
+    const int ERROR{::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &sp)};
+    if (0 != ERROR) {
+        std::cerr << "[opendlv-device-ps3controller]: Warning: Could not set real-time priority " << priority << ": " << ERROR << ": " << strerror(ERROR)
+                  << ((EPERM == ERROR) ? " (missing CAP_SYS_NICE?)" : "") << "; continuing with default scheduling." << std::endl;
+    }
+    return 0 == ERROR;
+}
+
+bool setCpuAffinity(int32_t cpu) noexcept {
+    int error{EINVAL};
+    if ( (0 <= cpu) && (CPU_SETSIZE > cpu) ) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(static_cast<std::size_t>(cpu), &cpuset);
+        error = ::pthread_setaffinity_np(::pthread_self(), sizeof(cpuset), &cpuset);
+    }
+    if (0 != error) {
+        std::cerr << "[opendlv-device-ps3controller]: Warning: Could not pin thread to CPU " << cpu << ": " << error << ": " << strerror(error) << "; continuing without affinity." << std::endl;
+    }
+    return 0 == error;
+}
+
+bool lockMemory() noexcept {
+    const bool RETVAL{0 == ::mlockall(MCL_CURRENT | MCL_FUTURE)};
+    if (!RETVAL) {
+        std::cerr << "[opendlv-device-ps3controller]: Warning: Could not lock memory: " << errno << ": " << strerror(errno)
+                  << ((EPERM == errno) ? " (missing CAP_IPC_LOCK?)" : "") << "; continuing without." << std::endl;
+    }
+    return RETVAL;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REALTIME_HPP
+#define REALTIME_HPP
+
+#include <cstdint>
+
+/**
+ * This method runs the calling thread with the real-time policy SCHED_FIFO.
+ * A warning is logged if the process lacks the required permissions (task
+ * scheduling needs CAP_SYS_NICE, e.g. docker run --cap-add=SYS_NICE).
+ *
+ * @param priority SCHED_FIFO priority [1, 99].
+ * @return true if the priority was set.
+ */
+bool setRealtimePriority(int32_t priority) noexcept;
+
+/**
+ * This method restricts the calling thread to the given CPU.
+ *
+ * @param cpu CPU to run on.
+ * @return true if the affinity was set.
+ */
+bool setCpuAffinity(int32_t cpu) noexcept;
+
+/**
+ * This method locks all current and future pages of the process into RAM
+ * to avoid page faults on the hot paths.
+ *
+ * @return true if the memory was locked.
+ */
+bool lockMemory() noexcept;
+
+#endif
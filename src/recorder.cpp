@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "recorder.hpp"
+
+#include <iostream>
+
+Recorder::Recorder(const std::string &file) noexcept
+    : m_file(file, std::ios::out | std::ios::binary | std::ios::trunc) {
+    if (!m_file.good()) {
+        std::cerr << "[opendlv-device-ps3controller]: Could not open " << file << " for recording." << std::endl;
+    }
+}
+
+bool Recorder::isOpen() const noexcept {
+    return m_file.is_open();
+}
+
+void Recorder::write(const std::string &envelope) noexcept {
+    std::lock_guard<std::mutex> lck(m_fileMutex);
+    m_file.write(envelope.data(), static_cast<std::streamsize>(envelope.size()));
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RECORDER_HPP
+#define RECORDER_HPP
+
+#include <fstream>
+#include <mutex>
+#include <string>
+
+/**
+ * This class writes serialized envelopes to a file in the .rec format read
+ * by cluon::Player and cluon-replay; it can be used from several threads.
+ */
+class Recorder {
+   private:
+    Recorder(const Recorder &) = delete;
+    Recorder(Recorder &&)      = delete;
+    Recorder &operator=(const Recorder &) = delete;
+    Recorder &operator=(Recorder &&) = delete;
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param file File to write; an existing one is overwritten.
+     */
+    explicit Recorder(const std::string &file) noexcept;
+    ~Recorder() = default;
+
+    /**
+     * @return true if the file could be opened.
+     */
+    bool isOpen() const noexcept;
+
+    /**
+     * This method appends an envelope.
+     *
+     * @param envelope Envelope serialized including the OD4 header.
+     */
+    void write(const std::string &envelope) noexcept;
+
+   private:
+    std::mutex m_fileMutex{};
+    std::ofstream m_file;
+};
+
+#endif
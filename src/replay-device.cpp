@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cluon-complete.hpp"
+#include "controllereventmessage.hpp"
+#include "replay-device.hpp"
+
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    int64_t monotonicInNanoseconds() noexcept {
+        struct timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 * 1000 + static_cast<int64_t>(ts.tv_nsec);
+    }
+}
+
+ReplayDevice::ReplayDevice(const std::string &name, std::vector<Event> &&events, double speed) noexcept
+    : m_name{name}
+    , m_events{std::move(events)}
+    , m_speed{speed} {
+    for (const Event &e : m_events) {
+        if ( (AXIS == e.type) && (e.number < InputEvents::MAX_NUMBER_OF_AXES) && (m_numberOfAxes <= e.number) ) {
+            m_numberOfAxes = e.number + 1u;
+        }
+        if ( (BUTTON == e.type) && (e.number < InputEvents::MAX_NUMBER_OF_BUTTONS) && (m_numberOfButtons <= e.number) ) {
+            m_numberOfButtons = e.number + 1u;
+        }
+    }
+
+    if (0 < m_speed) {
+        // Wake up at the scaled original time point of the next event.
+        m_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        m_startInNanoseconds = monotonicInNanoseconds();
+        armTimer();
+    }
+    else {
+        // An eventfd that is never read empty keeps the device readable.
+        m_fd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    if (-1 == m_fd) {
+        std::cerr << "[opendlv-device-ps3controller]: Could not set up replaying: " << errno << ": " << strerror(errno) << std::endl;
+    }
+}
+
+ReplayDevice::~ReplayDevice() {
+    if (-1 != m_fd) {
+        ::close(m_fd);
+    }
+}
+
+std::string ReplayDevice::name() const noexcept {
+    return m_name;
+}
+
+uint32_t ReplayDevice::numberOfAxes() const noexcept {
+    return m_numberOfAxes;
+}
+
+uint32_t ReplayDevice::numberOfButtons() const noexcept {
+    return m_numberOfButtons;
+}
+
+int ReplayDevice::fileDescriptor() const noexcept {
+    return m_fd;
+}
+
+bool ReplayDevice::read(InputEvents &events) noexcept {
+    if (m_next >= m_events.size()) {
+        std::clog << "[opendlv-device-ps3controller]: Replay finished." << std::endl;
+        return false;
+    }
+
+    const int64_t NOW{std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count()};
+    const int64_t FIRST{m_events.front().sampleTimeInMicroseconds};
+    std::size_t last{m_next + EVENTS_PER_READ};
+    if (0 < m_speed) {
+        uint64_t expirations{0};
+        const ssize_t CONSUMED{::read(m_fd, &expirations, sizeof(expirations))};
+        (void)CONSUMED;
+
+        // Hand out all events that are due.
+        const int64_t ELAPSED_IN_MICROSECONDS{static_cast<int64_t>(static_cast<double>(monotonicInNanoseconds() - m_startInNanoseconds) / 1000.0 * m_speed)};
+        last = m_next;
+        while ( (last < m_events.size()) && (m_events[last].sampleTimeInMicroseconds - FIRST <= ELAPSED_IN_MICROSECONDS) ) {
+            last++;
+        }
+    }
+    last = std::min(last, m_events.size());
+
+    for (; m_next < last; m_next++) {
+        const Event &e = m_events[m_next];
+        if ( (AXIS == e.type) && (e.number < m_numberOfAxes) ) {
+            events.axisValues[e.number] = e.value;
+            events.axisSampleTimesInMicroseconds[e.number] = NOW;
+            events.updatedAxes.set(e.number);
+            events.numberOfEvents++;
+        }
+        else if ( (BUTTON == e.type) && (e.number < m_numberOfButtons) ) {
+            events.buttons.set(e.number, 0 != e.value);
+            events.buttonSampleTimesInMicroseconds[e.number] = NOW;
+            events.updatedButtons.set(e.number);
+            events.numberOfEvents++;
+        }
+    }
+
+    if (0 < m_speed) {
+        armTimer();
+    }
+    return true;
+}
+
+void ReplayDevice::armTimer() noexcept {
+    // Once all events are handed out, fire right away to report the end of the replay.
+    int64_t timeout{m_startInNanoseconds};
+    if (m_next < m_events.size()) {
+        const int64_t OFFSET_IN_MICROSECONDS{m_events[m_next].sampleTimeInMicroseconds - m_events.front().sampleTimeInMicroseconds};
+        timeout += std::llround(static_cast<double>(OFFSET_IN_MICROSECONDS) * 1000.0 / m_speed);
+    }
+    // A zero it_value would disarm the timer.
+    timeout = std::max<int64_t>(timeout, 1);
+
+    struct itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(timeout / (1000 * 1000 * 1000));
+    spec.it_value.tv_nsec = static_cast<long>(timeout % (1000 * 1000 * 1000));
+    ::timerfd_settime(m_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+std::map<uint32_t, std::vector<ReplayDevice::Event>> loadRecording(const std::string &file) noexcept {
+    std::map<uint32_t, std::vector<ReplayDevice::Event>> retVal;
+    std::ifstream recording(file, std::ios::in | std::ios::binary);
+    if (!recording.good()) {
+        std::cerr << "[opendlv-device-ps3controller]: Could not open " << file << " for replaying." << std::endl;
+    }
+    while (recording.good()) {
+        auto entry{cluon::extractEnvelope(recording)};
+        if (entry.first && (opendlv::proxy::ControllerEvent::ID() == entry.second.dataType())) {
+            const uint32_t SENDER_STAMP{entry.second.senderStamp()};
+            ReplayDevice::Event e;
+            e.sampleTimeInMicroseconds = cluon::time::toMicroseconds(entry.second.sampleTimeStamp());
+            opendlv::proxy::ControllerEvent ce{cluon::extractMessage<opendlv::proxy::ControllerEvent>(std::move(entry.second))};
+            e.type = ce.type();
+            e.number = ce.number();
+            e.value = ce.value();
+            retVal[SENDER_STAMP].push_back(e);
+        }
+    }
+
+    // Envelopes sent from different threads may be slightly out of order.
+    for (auto &events : retVal) {
+        std::stable_sort(events.second.begin(), events.second.end(), [](const ReplayDevice::Event &a, const ReplayDevice::Event &b) {
+            return a.sampleTimeInMicroseconds < b.sampleTimeInMicroseconds;
+        });
+    }
+    return retVal;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPLAY_DEVICE_HPP
+#define REPLAY_DEVICE_HPP
+
+#include "input-device.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * This class hands out the axis and button changes of a controller recorded
+ * with --record as if they were read from the device itself. Events are
+ * replayed in their original timing scaled by a speed factor, or as fast as
+ * possible; their sample times are moved onto the time of replaying.
+ */
+class ReplayDevice : public InputDevice {
+   private:
+    ReplayDevice(const ReplayDevice &) = delete;
+    ReplayDevice(ReplayDevice &&)      = delete;
+    ReplayDevice &operator=(const ReplayDevice &) = delete;
+    ReplayDevice &operator=(ReplayDevice &&) = delete;
+
+   public:
+    // Recorded change of one axis or button.
+    struct Event {
+        int64_t sampleTimeInMicroseconds{0};
+        uint8_t type{0};
+        uint16_t number{0};
+        int16_t value{0};
+    };
+    enum : uint8_t { BUTTON = 1, AXIS = 2 };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param name Name of the replayed controller.
+     * @param events Recorded events in ascending order of their sample times.
+     * @param speed Factor to speed up the replay or 0 to replay as fast as possible.
+     */
+    ReplayDevice(const std::string &name, std::vector<Event> &&events, double speed) noexcept;
+    ~ReplayDevice() override;
+
+   public:
+    std::string name() const noexcept override;
+    uint32_t numberOfAxes() const noexcept override;
+    uint32_t numberOfButtons() const noexcept override;
+    int fileDescriptor() const noexcept override;
+    bool read(InputEvents &events) noexcept override;
+
+   private:
+    void armTimer() noexcept;
+
+   private:
+    enum { EVENTS_PER_READ = 64 };
+
+    std::string m_name;
+    std::vector<Event> m_events;
+    std::size_t m_next{0};
+    // Kept in double precision so that long recordings do not drift.
+    double m_speed{1.0};
+    int m_fd{-1};
+    uint32_t m_numberOfAxes{0};
+    uint32_t m_numberOfButtons{0};
+
+    // Monotonic time point in nanoseconds that corresponds to the first event.
+    int64_t m_startInNanoseconds{0};
+};
+
+/**
+ * This method reads all opendlv.proxy.ControllerEvent messages from a file
+ * written with --record.
+ *
+ * @param file .rec file to read.
+ * @return Recorded events per sender stamp; empty on failure.
+ */
+std::map<uint32_t, std::vector<ReplayDevice::Event>> loadRecording(const std::string &file) noexcept;
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * This class hands over a snapshot of a trivially copyable value from one
+ * writing thread to any number of reading threads without locking: Readers
+ * never block the writer and retry only when they raced with a store.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type.");
+
+   private:
+    SeqLock(const SeqLock &) = delete;
+    SeqLock(SeqLock &&)      = delete;
+    SeqLock &operator=(const SeqLock &) = delete;
+    SeqLock &operator=(SeqLock &&) = delete;
+
+   public:
+    SeqLock() noexcept {
+        store(T{});
+    }
+    ~SeqLock() = default;
+
+    /**
+     * This method publishes a new value; it must be called from one thread only.
+     *
+     * @param v Value to publish.
+     */
+    void store(const T &v) noexcept {
+        uint64_t words[NUMBER_OF_WORDS]{};
+        std::memcpy(words, &v, sizeof(T));
+
+        const uint32_t SEQUENCE{m_sequence.load(std::memory_order_relaxed)};
+        m_sequence.store(SEQUENCE + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i{0}; i < NUMBER_OF_WORDS; i++) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_sequence.store(SEQUENCE + 2, std::memory_order_release);
+    }
+
+    /**
+     * @return Most recently published value.
+     */
+    T load() const noexcept {
+        uint64_t words[NUMBER_OF_WORDS]{};
+        uint32_t before{0};
+        uint32_t after{0};
+        do {
+            before = m_sequence.load(std::memory_order_acquire);
+            for (std::size_t i{0}; i < NUMBER_OF_WORDS; i++) {
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+        } while ((before != after) || (0 != (before & 1)));
+
+        T v;
+        std::memcpy(&v, words, sizeof(T));
+        return v;
+    }
+
+   private:
+    static constexpr std::size_t NUMBER_OF_WORDS{(sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t)};
+
+    std::atomic<uint32_t> m_sequence{0};
+    std::atomic<uint64_t> m_words[NUMBER_OF_WORDS]{};
+};
+
+#endif
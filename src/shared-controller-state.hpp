@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHARED_CONTROLLER_STATE_HPP
+#define SHARED_CONTROLLER_STATE_HPP
+
+#include "seqlock.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Latest values of one controller as written to the shared memory area
+ * given with --shm.
+ */
+struct SharedControllerState {
+    // Counts the updates of this controller; 0 if it was never written.
+    uint64_t sequenceNumber{0};
+    // Time point in microseconds since epoch when the values were captured; 0 if unknown.
+    int64_t sampleTimeInMicroseconds{0};
+    // Time point in microseconds since epoch when the values were written.
+    int64_t writtenTimeInMicroseconds{0};
+    uint32_t senderStamp{0};
+    float acceleration{0};
+    float steering{0};
+    // 0 while the controller is disconnected, emergency stopped, or the microservice stopped.
+    uint8_t isValid{0};
+};
+
+/**
+ * Layout of the shared memory area given with --shm, placed at the first
+ * suitably aligned address of cluon::SharedMemory::data(). The values are written without taking the
+ * area's lock; readers on the same host attach with cluon::SharedMemory,
+ * check the magic number, and load a controller's latest values from its
+ * SeqLock without any system call. The shared condition is notified after
+ * each update for readers that prefer to wait.
+ */
+struct SharedControllerStates {
+    enum : uint32_t {
+        // "PS3C"; written last when the area is initialized.
+        MAGIC                     = 0x43335350,
+        MAX_NUMBER_OF_CONTROLLERS = 16,
+    };
+
+    std::atomic<uint32_t> magic{0};
+    uint32_t numberOfControllers{0};
+    SeqLock<SharedControllerState> controllers[MAX_NUMBER_OF_CONTROLLERS];
+
+    /**
+     * @return Size to request for the shared memory area.
+     */
+    static uint32_t size() noexcept {
+        return static_cast<uint32_t>(sizeof(SharedControllerStates) + alignof(SharedControllerStates));
+    }
+
+    /**
+     * @param data Start of the shared memory area as returned by cluon::SharedMemory::data().
+     * @return Address of the layout in the area; SysV areas start unaligned.
+     */
+    static void *at(char *data) noexcept {
+        const uintptr_t ALIGNMENT{alignof(SharedControllerStates)};
+        return reinterpret_cast<void *>((reinterpret_cast<uintptr_t>(data) + ALIGNMENT - 1) & ~(ALIGNMENT - 1));
+    }
+};
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * This class is a bounded ring buffer to pass values from exactly one
+ * producing to exactly one consuming thread without locking or system
+ * calls; a full ring rejects new values instead of blocking the producer.
+ */
+template <typename T, std::size_t CAPACITY>
+class SpscRing {
+    static_assert((0 < CAPACITY) && (0 == (CAPACITY & (CAPACITY - 1))), "SpscRing requires a power of two as capacity.");
+
+   private:
+    SpscRing(const SpscRing &) = delete;
+    SpscRing(SpscRing &&)      = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+    SpscRing &operator=(SpscRing &&) = delete;
+
+   public:
+    SpscRing() = default;
+    ~SpscRing() = default;
+
+    /**
+     * This method appends a value; it must be called from the producing thread only.
+     *
+     * @param v Value to append.
+     * @return false if the ring is full.
+     */
+    bool push(const T &v) noexcept {
+        const std::size_t HEAD{m_head.load(std::memory_order_relaxed)};
+        if (CAPACITY == HEAD - m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        m_values[HEAD & (CAPACITY - 1)] = v;
+        m_head.store(HEAD + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * This method removes the oldest value; it must be called from the consuming thread only.
+     *
+     * @param v Value to set.
+     * @return false if the ring is empty.
+     */
+    bool pop(T &v) noexcept {
+        const std::size_t TAIL{m_tail.load(std::memory_order_relaxed)};
+        if (TAIL == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        v = m_values[TAIL & (CAPACITY - 1)];
+        m_tail.store(TAIL + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @return true if the ring is empty; it must be called from the consuming thread only.
+     */
+    bool isEmpty() const noexcept {
+        return m_tail.load(std::memory_order_relaxed) == m_head.load(std::memory_order_acquire);
+    }
+
+   private:
+    // The indices are padded to separate cache lines to not slow down the other thread.
+    enum : std::size_t { CACHE_LINE_SIZE = 64 };
+    std::atomic<std::size_t> m_head{0};
+    char m_headPadding[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)]{};
+    std::atomic<std::size_t> m_tail{0};
+    char m_tailPadding[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)]{};
+    std::array<T, CAPACITY> m_values{};
+};
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "verbose-log.hpp"
+#include "axis-mapping.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+VerboseLog::VerboseLog(uint32_t maximumRate, uint32_t sample) noexcept
+    : m_maximumRate{maximumRate}
+    , m_sample{(0 < sample) ? sample : 1}
+    , m_wakeupEvent{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)} {
+    m_printingThread = std::thread(&VerboseLog::drain, this);
+}
+
+VerboseLog::~VerboseLog() {
+    m_isRunning = false;
+    wakeUp(true);
+    if (m_printingThread.joinable()) {
+        m_printingThread.join();
+    }
+    if (-1 != m_wakeupEvent) {
+        ::close(m_wakeupEvent);
+    }
+}
+
+void VerboseLog::fromReadingThread(const Record &record) noexcept {
+    if (!m_readingThreadRecords.push(record)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeUp(false);
+}
+
+void VerboseLog::fromSendingThread(const Record &record) noexcept {
+    if (!m_sendingThreadRecords.push(record)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeUp(false);
+}
+
+void VerboseLog::wakeUp(bool isStopping) noexcept {
+    // Pairs with the fence in drain: either the printing thread sees the
+    // pushed record before sleeping or this thread sees it waiting.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if ( (-1 != m_wakeupEvent) && (isStopping || (m_isWaiting.load(std::memory_order_relaxed) && m_isWaiting.exchange(false))) ) {
+        const uint64_t WAKEUP{1};
+        if (0 > ::write(m_wakeupEvent, &WAKEUP, sizeof(WAKEUP))) {
+            std::cerr << "[opendlv-device-ps3controller]: Could not wake up verbose output: " << errno << ": " << strerror(errno) << std::endl;
+        }
+    }
+}
+
+void VerboseLog::drain() noexcept {
+    std::vector<Record> fromReading;
+    std::vector<Record> fromSending;
+    std::vector<Record> merged;
+    fromReading.reserve(CAPACITY);
+    fromSending.reserve(CAPACITY);
+    merged.reserve(2 * CAPACITY);
+
+    std::chrono::steady_clock::time_point currentSecond{std::chrono::steady_clock::now()};
+    bool isRunning{true};
+    do {
+        // The remaining records are printed once more after being stopped.
+        isRunning = m_isRunning.load();
+
+        Record record;
+        fromReading.clear();
+        fromSending.clear();
+        while (m_readingThreadRecords.pop(record)) {
+            fromReading.push_back(record);
+        }
+        while (m_sendingThreadRecords.pop(record)) {
+            fromSending.push_back(record);
+        }
+        merged.clear();
+        std::merge(fromReading.begin(), fromReading.end(), fromSending.begin(), fromSending.end(), std::back_inserter(merged),
+                   [](const Record &a, const Record &b) { return a.timeInMicroseconds < b.timeInMicroseconds; });
+
+        for (const Record &r : merged) {
+            if ( (0 == (m_numberOfRecords++ % m_sample)) && ((0 == m_maximumRate) || (m_printedInCurrentSecond < m_maximumRate)) ) {
+                print(r);
+                m_printedInCurrentSecond++;
+            }
+            else {
+                m_skipped++;
+            }
+        }
+
+        // Report the records that were not printed once per second.
+        const std::chrono::steady_clock::time_point NOW{std::chrono::steady_clock::now()};
+        if ( (NOW - currentSecond >= std::chrono::seconds(1)) || !isRunning ) {
+            const uint64_t DROPPED{m_dropped.exchange(0, std::memory_order_relaxed)};
+            if ( (0 < m_skipped) || (0 < DROPPED) ) {
+                std::cout << "[opendlv-device-ps3controller]: Skipped " << m_skipped << " and dropped " << DROPPED << " verbose records." << '\n';
+            }
+            currentSecond = NOW;
+            m_printedInCurrentSecond = 0;
+            m_skipped = 0;
+        }
+        std::cout.flush();
+
+        if (isRunning && !merged.empty()) {
+            // Collect the following records for a while to wake up at most 100 times per second.
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        else if (isRunning) {
+            // Sleep until new records arrive, or until the end of the current second to report the skipped ones.
+            int timeoutInMilliseconds{-1};
+            if (0 < m_skipped) {
+                const auto REMAINING{std::chrono::seconds(1) - (std::chrono::steady_clock::now() - currentSecond)};
+                timeoutInMilliseconds = static_cast<int>(std::max<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(REMAINING).count(), 0)) + 1;
+            }
+            if (-1 == m_wakeupEvent) {
+                timeoutInMilliseconds = 10;
+            }
+            m_isWaiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_readingThreadRecords.isEmpty() && m_sendingThreadRecords.isEmpty() && m_isRunning.load()) {
+                struct pollfd fds{m_wakeupEvent, POLLIN, 0};
+                ::poll(&fds, 1, timeoutInMilliseconds);
+            }
+            m_isWaiting.store(false, std::memory_order_relaxed);
+            uint64_t value{0};
+            if ( (-1 != m_wakeupEvent) && (0 > ::read(m_wakeupEvent, &value, sizeof(value))) && (EAGAIN != errno) ) {
+                std::cerr << "[opendlv-device-ps3controller]: Could not read verbose output wakeup: " << errno << ": " << strerror(errno) << std::endl;
+            }
+        }
+    } while (isRunning);
+}
+
+void VerboseLog::print(const Record &record) noexcept {
+    const int16_t value{record.value};
+    const float percent{AxisMapping::toPercent(value)};
+    switch (record.kind) {
+        case Record::STEERING:
+            if (percent > 49.95f && percent < 50.05f) {
+                std::cout << "[opendlv-device-ps3controller]: Going straight." << '\n';
+            }
+            else {
+                // this will return values in the range [0-100] for both a left or right turn (instead of [0-50] for left and [50-100] for right)
+                std::cout << "[opendlv-device-ps3controller]: Turning "<< (value<0?"left":"right") << " at " << (value<0?(100.0f-2.0f*percent):(2.0f*percent-100.0f)) <<"%." << '\n';
+            }
+            break;
+        case Record::ACCELERATION:
+            // this will return values in the range [0-100] for both accelerating and braking (instead of [50-0] for accelerating and [50-100] for braking)
+            std::cout << "[opendlv-device-ps3controller]: " << (value<0?"Accelerating":"Braking") <<" at "<< (value<0?(100.0f-2.0f*percent):(2.0f*percent-100.0f)) << "%." << '\n';
+            break;
+        case Record::SENT:
+            std::cout << "acceleration = " << record.acceleration << '\n'
+                      << "steering = " << record.steering << '\n'
+                      << "isValid = " << record.isValid << '\n' << '\n';
+            break;
+    }
+}
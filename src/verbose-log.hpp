@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VERBOSE_LOG_HPP
+#define VERBOSE_LOG_HPP
+
+#include "spsc-ring.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+/**
+ * This class prints the output of --verbose from a thread of its own: The
+ * reading and the sending thread only copy small binary records into their
+ * own SpscRing, which are formatted and printed off their paths. The printing
+ * thread sleeps on an eventfd while both rings are empty and is only woken up
+ * by the first record pushed after it went to sleep. At most
+ * the given number of records is printed per second and only every n-th of
+ * them; records that were skipped or did not fit into a ring are counted
+ * and reported instead.
+ */
+class VerboseLog {
+   private:
+    VerboseLog(const VerboseLog &) = delete;
+    VerboseLog(VerboseLog &&)      = delete;
+    VerboseLog &operator=(const VerboseLog &) = delete;
+    VerboseLog &operator=(VerboseLog &&) = delete;
+
+   public:
+    struct Record {
+        enum Kind : uint8_t { STEERING, ACCELERATION, SENT };
+
+        Kind kind{STEERING};
+        // Time point in microseconds since epoch, used to order the records of both threads.
+        int64_t timeInMicroseconds{0};
+        // Raw axis value for STEERING and ACCELERATION.
+        int16_t value{0};
+        // Sent values for SENT.
+        float acceleration{0};
+        float steering{0};
+        bool isValid{false};
+    };
+
+   public:
+    /**
+     * Constructor.
+     *
+     * @param maximumRate Maximum number of records to print per second; 0 to print all.
+     * @param sample Print only every sample-th record.
+     */
+    VerboseLog(uint32_t maximumRate, uint32_t sample) noexcept;
+    ~VerboseLog();
+
+    /**
+     * This method logs a record; it must be called from the reading thread only.
+     *
+     * @param record Record to log.
+     */
+    void fromReadingThread(const Record &record) noexcept;
+
+    /**
+     * This method logs a record; it must be called from the sending thread only.
+     *
+     * @param record Record to log.
+     */
+    void fromSendingThread(const Record &record) noexcept;
+
+   private:
+    void wakeUp(bool isStopping) noexcept;
+    void drain() noexcept;
+    void print(const Record &record) noexcept;
+
+   private:
+    enum : std::size_t { CAPACITY = 4096 };
+
+    const uint32_t m_maximumRate;
+    const uint32_t m_sample;
+
+    // Signalled to wake up the printing thread; set while it waits for records.
+    int m_wakeupEvent;
+    std::atomic<bool> m_isWaiting{false};
+
+    SpscRing<Record, CAPACITY> m_readingThreadRecords{};
+    SpscRing<Record, CAPACITY> m_sendingThreadRecords{};
+    std::atomic<uint64_t> m_dropped{0};
+
+    // Used by the printing thread only.
+    uint64_t m_numberOfRecords{0};
+    uint32_t m_printedInCurrentSecond{0};
+    uint64_t m_skipped{0};
+
+    std::atomic<bool> m_isRunning{true};
+    std::thread m_printingThread{};
+};
+
+#endif